@@ -0,0 +1,105 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "symbolic.h"
+
+#define FRAMES 256
+#define ITERATIONS 2000
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *label, double elapsed) {
+    double per_frame = elapsed / ((double)FRAMES * ITERATIONS) * 1e9;
+    printf("  %-24s %8.1f ns/frame\n", label, per_frame);
+}
+
+// Symbolicates a thread one frame at a time.
+static double bench_single(const SymbolicSymCache *symcache,
+                           const uint64_t *addrs) {
+    size_t total = 0;
+    double start = now();
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        for (size_t j = 0; j < FRAMES; j++) {
+            SymbolicLookupResult result =
+                symbolic_symcache_lookup(symcache, addrs[j]);
+            total += result.len;
+            symbolic_lookup_result_free(&result);
+        }
+    }
+
+    double elapsed = now() - start;
+    assert(total > 0);
+    return elapsed;
+}
+
+// Symbolicates a thread with one batch lookup into a reused buffer.
+static double bench_batch(const SymbolicSymCache *symcache,
+                          const uint64_t *addrs) {
+    SymbolicLookupSpan spans[FRAMES];
+    size_t capacity = FRAMES;
+    SymbolicSourceLocation *items = malloc(capacity * sizeof(*items));
+    size_t total = 0;
+    double start = now();
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        size_t count = symbolic_symcache_lookup_batch(symcache, addrs, FRAMES,
+                                                      items, capacity, spans);
+        if (count > capacity) {
+            capacity = count;
+            items = realloc(items, capacity * sizeof(*items));
+            count = symbolic_symcache_lookup_batch(symcache, addrs, FRAMES,
+                                                   items, capacity, spans);
+        }
+
+        total += count;
+        symbolic_source_locations_free(items, count);
+    }
+
+    double elapsed = now() - start;
+    assert(total > 0);
+    free(items);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1
+        ? argv[1]
+        : "../symbolic-testutils/fixtures/linux/crash.debug";
+
+    SymbolicArchive *archive = symbolic_archive_open(path);
+    assert(archive != 0);
+    SymbolicObject *object = symbolic_archive_get_object(archive, 0);
+    assert(object != 0);
+    SymbolicSymCache *symcache = symbolic_symcache_from_object(object);
+    assert(symcache != 0);
+
+    // A thread of frames scattered across the text section of the fixture.
+    uint64_t addrs[FRAMES];
+    uint64_t state = 0x9e3779b97f4a7c15;
+    for (size_t i = 0; i < FRAMES; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        addrs[i] = 0x1558 + state % 0x13700;
+    }
+
+    printf("[BENCH] symcache lookup, %d frames per thread:\n", FRAMES);
+    report("symbolic_symcache_lookup", bench_single(symcache, addrs));
+    report("batch lookup", bench_batch(symcache, addrs));
+
+    symbolic_symcache_free(symcache);
+    symbolic_object_free(object);
+    symbolic_archive_free(archive);
+
+    return 0;
+}
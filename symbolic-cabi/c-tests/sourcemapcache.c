@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbolic.h"
+
+#define POSITION_COUNT 200
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    assert(file != 0);
+    fseek(file, 0, SEEK_END);
+    *len = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = malloc(*len);
+    assert(fread(data, 1, *len, file) == *len);
+    fclose(file);
+    return data;
+}
+
+static int str_eq(SymbolicStr a, SymbolicStr b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+void test_sourcemapcache_lookup_tokens(void) {
+    printf("[TEST] batch token lookup matches single lookups:\n");
+
+    size_t source_len, sourcemap_len;
+    char *source = read_file("../symbolic-testutils/fixtures/sourcemapcache/preact.module.js",
+                             &source_len);
+    char *sourcemap = read_file(
+        "../symbolic-testutils/fixtures/sourcemapcache/preact.module.js.map", &sourcemap_len);
+
+    SymbolicSourceMapCache *cache =
+        symbolic_sourcemapcache_from_bytes(source, source_len, sourcemap, sourcemap_len);
+    assert(cache != 0);
+
+    // Descending columns, to exercise sorting. Column 0 is never resolved.
+    SymbolicSmPosition positions[POSITION_COUNT];
+    for (size_t i = 0; i < POSITION_COUNT; i++) {
+        positions[i].line = 1;
+        positions[i].col = (uint32_t)((POSITION_COUNT - 1 - i) * 50);
+    }
+
+    SymbolicSmToken tokens[POSITION_COUNT];
+    size_t count =
+        symbolic_sourcemapcache_lookup_tokens(cache, positions, POSITION_COUNT, tokens);
+    assert(symbolic_err_get_last_code() == SYMBOLIC_ERROR_CODE_NO_ERROR);
+    printf("  resolved tokens: %zu\n", count);
+    assert(count > 0);
+
+    size_t resolved = 0;
+    for (size_t i = 0; i < POSITION_COUNT; i++) {
+        SymbolicSmTokenMatch *expected = NULL;
+        if (positions[i].col > 0) {
+            expected = symbolic_sourcemapcache_lookup_token(cache, positions[i].line,
+                                                            positions[i].col, 0);
+        }
+
+        SymbolicSmToken *actual = &tokens[i];
+        if (expected == NULL) {
+            assert(actual->line == 0);
+            assert(actual->col == 0);
+            continue;
+        }
+
+        resolved++;
+        assert(actual->line == expected->line);
+        assert(actual->col == expected->col);
+        assert(str_eq(actual->src, expected->src));
+        assert(str_eq(actual->name, expected->name));
+        assert(str_eq(actual->function_name, expected->function_name));
+        assert(str_eq(actual->context_line, expected->context_line));
+
+        symbolic_sourcemapcache_token_match_free(expected);
+    }
+
+    assert(resolved == count);
+
+    symbolic_sourcemapcache_free(cache);
+    free(sourcemap);
+    free(source);
+    symbolic_err_clear();
+
+    printf("  PASS\n\n");
+}
+
+int main() {
+    test_sourcemapcache_lookup_tokens();
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbolic.h"
+
+#define ADDR_COUNT 4096
+
+static int str_eq(SymbolicStr a, SymbolicStr b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+void test_symcache_lookup_batch(void) {
+    printf("[TEST] batch lookup matches single lookups:\n");
+
+    SymbolicArchive *archive =
+        symbolic_archive_open("../symbolic-testutils/fixtures/linux/crash.debug");
+    assert(archive != 0);
+    SymbolicObject *object = symbolic_archive_get_object(archive, 0);
+    assert(object != 0);
+    SymbolicSymCache *symcache = symbolic_symcache_from_object(object);
+    assert(symcache != 0);
+
+    uint64_t addrs[ADDR_COUNT];
+    for (size_t i = 0; i < ADDR_COUNT; i++) {
+        addrs[i] = 0x1000 + i * 4;
+    }
+
+    SymbolicLookupSpan spans[ADDR_COUNT];
+    size_t count = symbolic_symcache_lookup_batch(symcache, addrs, ADDR_COUNT,
+                                                  NULL, 0, spans);
+    assert(symbolic_err_get_last_code() == SYMBOLIC_ERROR_CODE_NO_ERROR);
+    printf("  source locations: %zu\n", count);
+    assert(count > 0);
+
+    SymbolicSourceLocation *items = malloc(count * sizeof(*items));
+    size_t written = symbolic_symcache_lookup_batch(symcache, addrs, ADDR_COUNT,
+                                                    items, count, spans);
+    assert(written == count);
+
+    size_t borrowed_paths = 0;
+    for (size_t i = 0; i < ADDR_COUNT; i++) {
+        SymbolicLookupResult result = symbolic_symcache_lookup(symcache, addrs[i]);
+        assert(result.len == spans[i].len);
+
+        for (size_t j = 0; j < result.len; j++) {
+            SymbolicSourceLocation *expected = &result.items[j];
+            SymbolicSourceLocation *actual = &items[spans[i].offset + j];
+
+            assert(actual->sym_addr == expected->sym_addr);
+            assert(actual->instr_addr == expected->instr_addr);
+            assert(actual->line == expected->line);
+            assert(str_eq(actual->lang, expected->lang));
+            assert(str_eq(actual->symbol, expected->symbol));
+            assert(str_eq(actual->full_path, expected->full_path));
+            assert(!actual->symbol.owned);
+
+            if (!actual->full_path.owned) {
+                borrowed_paths++;
+            }
+        }
+
+        symbolic_lookup_result_free(&result);
+    }
+
+    printf("  borrowed paths:   %zu\n", borrowed_paths);
+
+    symbolic_source_locations_free(items, count);
+    free(items);
+    symbolic_symcache_free(symcache);
+    symbolic_object_free(object);
+    symbolic_archive_free(archive);
+    symbolic_err_clear();
+
+    printf("  PASS\n\n");
+}
+
+int main() {
+    test_symcache_lookup_batch();
+
+    return 0;
+}
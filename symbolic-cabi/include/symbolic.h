@@ -250,6 +250,52 @@ typedef struct SymbolicSmTokenMatch {
   struct SymbolicStrVec post_context;
 } SymbolicSmTokenMatch;
 
+/**
+ * Represents a position in a minified file for a batch lookup.
+ */
+typedef struct SymbolicSmPosition {
+  /**
+   * The 1-indexed line number in the minified file.
+   */
+  uint32_t line;
+  /**
+   * The 1-indexed column number in the minified file.
+   */
+  uint32_t col;
+} SymbolicSmPosition;
+
+/**
+ * Represents a single token in a batch lookup.
+ *
+ * All strings are borrowed from the sourcemapcache.
+ */
+typedef struct SymbolicSmToken {
+  /**
+   * The line number in the original source file, or `0` if the position was not found.
+   */
+  uint32_t line;
+  /**
+   * The column number in the original source file, or `0` if the position was not found.
+   */
+  uint32_t col;
+  /**
+   * The path to the original source.
+   */
+  struct SymbolicStr src;
+  /**
+   * The name of the source location as it is defined in the SourceMap.
+   */
+  struct SymbolicStr name;
+  /**
+   * The name of the function containing the token.
+   */
+  struct SymbolicStr function_name;
+  /**
+   * The contents of the original source line.
+   */
+  struct SymbolicStr context_line;
+} SymbolicSmToken;
+
 /**
  * Represents a single symbol after lookup.
  */
@@ -270,6 +316,16 @@ typedef struct SymbolicLookupResult {
   uintptr_t len;
 } SymbolicLookupResult;
 
+/**
+ * Represents the source locations of one address in a batch lookup.
+ *
+ * The source locations are stored in the items buffer passed to the lookup, starting at `offset`.
+ */
+typedef struct SymbolicLookupSpan {
+  uintptr_t offset;
+  uintptr_t len;
+} SymbolicLookupSpan;
+
 /**
  * Represents an instruction info.
  */
@@ -671,6 +727,21 @@ struct SymbolicSmTokenMatch *symbolic_sourcemapcache_lookup_token(const struct S
                                                                   uint32_t col,
                                                                   uint32_t context_lines);
 
+/**
+ * Looks up a batch of tokens into a caller-provided array.
+ *
+ * `tokens` must hold `positions_len` elements and receives the token at every position in
+ * the same order. Positions that cannot be resolved are written with a line and column of
+ * `0`. The strings of all tokens are borrowed from the sourcemapcache and are valid until it
+ * is freed, so the tokens do not need to be freed.
+ *
+ * Returns the number of positions that were resolved.
+ */
+uintptr_t symbolic_sourcemapcache_lookup_tokens(const struct SymbolicSourceMapCache *source_map,
+                                                const struct SymbolicSmPosition *positions,
+                                                uintptr_t positions_len,
+                                                struct SymbolicSmToken *tokens);
+
 /**
  * Free a token match.
  */
@@ -735,6 +806,34 @@ struct SymbolicLookupResult symbolic_symcache_lookup(const struct SymbolicSymCac
  */
 void symbolic_lookup_result_free(struct SymbolicLookupResult *lookup_result);
 
+/**
+ * Looks up a batch of addresses into caller-provided buffers.
+ *
+ * The source locations of all addresses, including inlined functions, are written to `items`
+ * in order. `spans` must hold `addrs_len` elements and receives the position of every
+ * address's source locations in `items`.
+ *
+ * Symbol names and languages are borrowed from the symcache and are valid until it is freed.
+ * File paths are borrowed as well, unless they have to be assembled from several
+ * directories. Call `symbolic_source_locations_free` on the written items to release those.
+ *
+ * Returns the total number of source locations. If this exceeds `items_len`, the items are
+ * released again and the lookup must be repeated with a buffer of at least that size.
+ */
+uintptr_t symbolic_symcache_lookup_batch(const struct SymbolicSymCache *symcache,
+                                         const uint64_t *addrs,
+                                         uintptr_t addrs_len,
+                                         struct SymbolicSourceLocation *items,
+                                         uintptr_t items_len,
+                                         struct SymbolicLookupSpan *spans);
+
+/**
+ * Frees the strings owned by source locations from `symbolic_symcache_lookup_batch`.
+ *
+ * This does not free the `items` buffer itself, which belongs to the caller.
+ */
+void symbolic_source_locations_free(struct SymbolicSourceLocation *items, uintptr_t len);
+
 /**
  * Return the best instruction for an isntruction info.
  */
@@ -59,6 +59,34 @@ pub struct SymbolicSmTokenMatch {
     pub post_context: SymbolicStrVec,
 }
 
+/// Represents a position in a minified file for a batch lookup.
+#[repr(C)]
+pub struct SymbolicSmPosition {
+    /// The 1-indexed line number in the minified file.
+    pub line: u32,
+    /// The 1-indexed column number in the minified file.
+    pub col: u32,
+}
+
+/// Represents a single token in a batch lookup.
+///
+/// All strings are borrowed from the sourcemapcache.
+#[repr(C)]
+pub struct SymbolicSmToken {
+    /// The line number in the original source file, or `0` if the position was not found.
+    pub line: u32,
+    /// The column number in the original source file, or `0` if the position was not found.
+    pub col: u32,
+    /// The path to the original source.
+    pub src: SymbolicStr,
+    /// The name of the source location as it is defined in the SourceMap.
+    pub name: SymbolicStr,
+    /// The name of the function containing the token.
+    pub function_name: SymbolicStr,
+    /// The contents of the original source line.
+    pub context_line: SymbolicStr,
+}
+
 ffi_fn! {
     /// Creates an sourcemapcache from a given minified source and sourcemap contents.
     ///
@@ -171,6 +199,71 @@ ffi_fn! {
     }
 }
 
+ffi_fn! {
+    /// Looks up a batch of tokens into a caller-provided array.
+    ///
+    /// `tokens` must hold `positions_len` elements and receives the token at every position in
+    /// the same order. Positions that cannot be resolved are written with a line and column of
+    /// `0`. The strings of all tokens are borrowed from the sourcemapcache and are valid until it
+    /// is freed, so the tokens do not need to be freed.
+    ///
+    /// Returns the number of positions that were resolved.
+    unsafe fn symbolic_sourcemapcache_lookup_tokens(
+        source_map: *const SymbolicSourceMapCache,
+        positions: *const SymbolicSmPosition,
+        positions_len: usize,
+        tokens: *mut SymbolicSmToken,
+    ) -> Result<usize> {
+        let cache = SymbolicSourceMapCache::as_rust(source_map).get();
+        let positions = slice::from_raw_parts(positions, positions_len);
+
+        // Sentry JS events are 1-indexed, where SourcePosition is using 0-indexed locations.
+        // Lines and columns of `0` wrap around and are reported as unresolved below.
+        let positions: Vec<_> = positions
+            .iter()
+            .map(|position| {
+                SourcePosition::new(position.line.wrapping_sub(1), position.col.wrapping_sub(1))
+            })
+            .collect();
+
+        let mut count = 0;
+        for (idx, location) in cache.lookup_many(&positions) {
+            let position = &positions[idx];
+            let token = match location {
+                Some(location) if position.line != u32::MAX && position.column != u32::MAX => {
+                    count += 1;
+                    let function_name = match location.scope() {
+                        ScopeLookupResult::NamedScope(name) => name,
+                        ScopeLookupResult::AnonymousScope => "<anonymous>",
+                        ScopeLookupResult::Unknown => "<unknown>",
+                    };
+
+                    SymbolicSmToken {
+                        line: location.line() + 1,
+                        col: location.column() + 1,
+                        src: SymbolicStr::new(location.file_name().unwrap_or_default()),
+                        name: SymbolicStr::new(location.name().unwrap_or_default()),
+                        function_name: SymbolicStr::new(function_name),
+                        context_line: SymbolicStr::new(location.line_contents().unwrap_or_default()),
+                    }
+                }
+                _ => SymbolicSmToken {
+                    line: 0,
+                    col: 0,
+                    src: SymbolicStr::default(),
+                    name: SymbolicStr::default(),
+                    function_name: SymbolicStr::default(),
+                    context_line: SymbolicStr::default(),
+                },
+            };
+
+            tokens.add(idx).write(token);
+        }
+
+        Ok(count)
+    }
+}
+
 ffi_fn! {
     /// Free a token match.
     unsafe fn symbolic_sourcemapcache_token_match_free(token_match: *mut SymbolicSmTokenMatch) {
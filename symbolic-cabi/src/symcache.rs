@@ -36,6 +36,15 @@ pub struct SymbolicLookupResult {
     pub len: usize,
 }
 
+/// Represents the source locations of one address in a batch lookup.
+///
+/// The source locations are stored in the items buffer passed to the lookup, starting at `offset`.
+#[repr(C)]
+pub struct SymbolicLookupSpan {
+    pub offset: usize,
+    pub len: usize,
+}
+
 /// Represents an instruction info.
 #[repr(C)]
 pub struct SymbolicInstructionInfo {
@@ -176,6 +185,75 @@ ffi_fn! {
     }
 }
 
+ffi_fn! {
+    /// Looks up a batch of addresses into caller-provided buffers.
+    ///
+    /// The source locations of all addresses, including inlined functions, are written to `items`
+    /// in order. `spans` must hold `addrs_len` elements and receives the position of every
+    /// address's source locations in `items`.
+    ///
+    /// Symbol names and languages are borrowed from the symcache and are valid until it is freed.
+    /// File paths are borrowed as well, unless they have to be assembled from several
+    /// directories. Call `symbolic_source_locations_free` on the written items to release those.
+    ///
+    /// Returns the total number of source locations. If this exceeds `items_len`, the items are
+    /// released again and the lookup must be repeated with a buffer of at least that size.
+    unsafe fn symbolic_symcache_lookup_batch(
+        symcache: *const SymbolicSymCache,
+        addrs: *const u64,
+        addrs_len: usize,
+        items: *mut SymbolicSourceLocation,
+        items_len: usize,
+        spans: *mut SymbolicLookupSpan,
+    ) -> Result<usize> {
+        let cache = SymbolicSymCache::as_rust(symcache).get();
+        let addrs = slice::from_raw_parts(addrs, addrs_len);
+        let spans = slice::from_raw_parts_mut(spans, addrs_len);
+
+        let mut count = 0;
+        for (&addr, span) in addrs.iter().zip(spans) {
+            span.offset = count;
+
+            for source_location in cache.lookup(addr) {
+                if count < items_len {
+                    let function = source_location.function();
+                    let full_path = source_location.file().map(|file| file.full_path_cow());
+                    items.add(count).write(SymbolicSourceLocation {
+                        sym_addr: function.entry_pc() as u64,
+                        instr_addr: addr,
+                        line: source_location.line(),
+                        lang: SymbolicStr::new(function.language().name()),
+                        symbol: SymbolicStr::new(function.name()),
+                        full_path: full_path.unwrap_or_default().into(),
+                    });
+                } else if count == items_len {
+                    // Release the items written so far, since the caller has to start over.
+                    symbolic_source_locations_free(items, items_len);
+                }
+
+                count += 1;
+            }
+
+            span.len = count - span.offset;
+        }
+
+        Ok(count)
+    }
+}
+
+ffi_fn! {
+    /// Frees the strings owned by source locations from `symbolic_symcache_lookup_batch`.
+    ///
+    /// This does not free the `items` buffer itself, which belongs to the caller.
+    unsafe fn symbolic_source_locations_free(items: *mut SymbolicSourceLocation, len: usize) {
+        if !items.is_null() {
+            for item in slice::from_raw_parts_mut(items, len) {
+                item.full_path.free();
+            }
+        }
+    }
+}
+
 ffi_fn! {
     /// Return the best instruction for an isntruction info.
     unsafe fn symbolic_find_best_instruction(ii: *const SymbolicInstructionInfo) -> Result<u64> {
@@ -17,16 +17,21 @@
 //! [processor]: ../processor/index.html
 //! [`CfiCache`]: struct.CfiCache.html
 
-use std::collections::HashMap;
+use std::cmp::Reverse;
+use std::collections::{BTreeSet, HashMap};
 use std::error::Error;
 use std::fmt;
 use std::io::{self, Write};
 use std::ops::Range;
 
 use thiserror::Error;
+use watto::{align_to, Pod, Writer};
 
-use symbolic_common::{Arch, ByteView, CpuFamily, UnknownArchError};
-use symbolic_debuginfo::breakpad::{BreakpadError, BreakpadObject, BreakpadStackRecord};
+use symbolic_common::{Arch, ByteView, CpuFamily, ParallelIter, UnknownArchError};
+use symbolic_debuginfo::breakpad::{
+    BreakpadError, BreakpadObject, BreakpadStackCfiDeltaRecord, BreakpadStackCfiRecord,
+    BreakpadStackRecord, BreakpadStackRecords, BreakpadStackWinRecord,
+};
 use symbolic_debuginfo::dwarf::gimli::{
     BaseAddresses, CfaRule, CieOrFde, DebugFrame, EhFrame, Error as GimliError,
     FrameDescriptionEntry, Reader, ReaderOffset, Register, RegisterRule, UnwindContext,
@@ -41,6 +46,8 @@ use symbolic_debuginfo::pdb::PdbObject;
 use symbolic_debuginfo::pe::{PeObject, RuntimeFunction, StackFrameOffset, UnwindOperation};
 use symbolic_debuginfo::{Object, ObjectError, ObjectLike};
 
+mod raw;
+
 /// The magic file preamble to identify cficache files.
 ///
 /// Files with version < 2 do not have the full preamble with magic+version, but rather start
@@ -51,7 +58,7 @@ use symbolic_debuginfo::{Object, ObjectError, ObjectLike};
 pub const CFICACHE_MAGIC: u32 = u32::from_be_bytes(*b"CFIC");
 
 /// The latest version of the file format.
-pub const CFICACHE_LATEST_VERSION: u32 = 2;
+pub const CFICACHE_LATEST_VERSION: u32 = 3;
 
 // The preamble are 8 bytes, a 4-byte magic and 4 bytes for the version.
 // The 4-byte magic should be read as little endian to check for endian mismatch.
@@ -60,6 +67,11 @@ pub const CFICACHE_LATEST_VERSION: u32 = 2;
 //
 // 1: Initial ASCII-only implementation
 // 2: Implementation with a versioned preamble
+// 3: Binary address index and interned rules following the ASCII text, see the `raw` module. The
+//    text may be empty if the cache is only used for lookups.
+
+/// The approximate size of Breakpad stack record chunks parsed on a single thread.
+const BREAKPAD_CHUNK_SIZE: usize = 64 * 1024;
 
 /// Used to detect empty runtime function entries in PEs.
 const EMPTY_FUNCTION: RuntimeFunction = RuntimeFunction {
@@ -143,6 +155,9 @@ pub enum CfiErrorKind {
 
     /// Invalid magic bytes in the cfi cache header.
     BadFileMagic,
+
+    /// The binary index of the cfi cache is corrupted.
+    BadCacheFile,
 }
 
 impl fmt::Display for CfiErrorKind {
@@ -155,6 +170,7 @@ impl fmt::Display for CfiErrorKind {
             Self::InvalidAddress => write!(f, "invalid cfi address"),
             Self::WriteFailed => write!(f, "failed to write cfi"),
             Self::BadFileMagic => write!(f, "bad cfi cache magic"),
+            Self::BadCacheFile => write!(f, "bad cfi cache file"),
         }
     }
 }
@@ -356,12 +372,21 @@ fn cfi_register_name(arch: CpuFamily, register: u16) -> Option<&'static str> {
 /// ```
 pub struct AsciiCfiWriter<W: Write> {
     inner: W,
+    threads: usize,
 }
 
 impl<W: Write> AsciiCfiWriter<W> {
     /// Creates a new `AsciiCfiWriter` that outputs to a writer.
     pub fn new(inner: W) -> Self {
-        AsciiCfiWriter { inner }
+        AsciiCfiWriter { inner, threads: 0 }
+    }
+
+    /// Sets the number of threads used to parse stack records of Breakpad objects.
+    ///
+    /// By default, and with values of `0` or `1`, records are parsed on the current thread. The
+    /// output is identical regardless of the number of threads.
+    pub fn set_threads(&mut self, threads: usize) {
+        self.threads = threads;
     }
 
     /// Extracts CFI from the given object file.
@@ -384,7 +409,35 @@ impl<W: Write> AsciiCfiWriter<W> {
     }
 
     fn process_breakpad(&mut self, object: &BreakpadObject<'_>) -> Result<(), CfiError> {
-        for record in object.stack_records() {
+        if self.threads <= 1 {
+            return self.write_breakpad_records(object.stack_records());
+        }
+
+        // Workers only get a bounded number of chunks ahead, which bounds the buffered output.
+        let chunks: Vec<_> = object.stack_record_chunks(BREAKPAD_CHUNK_SIZE).collect();
+        std::thread::scope(|scope| {
+            let results = ParallelIter::new(scope, chunks.len(), self.threads, |index| {
+                let mut writer = AsciiCfiWriter::new(Vec::new());
+                let records = BreakpadStackRecords::new(chunks[index]);
+                let result = writer.write_breakpad_records(records);
+                (writer.into_inner(), result)
+            });
+
+            // Write chunks in order, including partial output of a chunk that failed to parse.
+            for (buffer, result) in results {
+                self.inner.write_all(&buffer)?;
+                result?;
+            }
+
+            Ok(())
+        })
+    }
+
+    fn write_breakpad_records(
+        &mut self,
+        records: BreakpadStackRecords<'_>,
+    ) -> Result<(), CfiError> {
+        for record in records {
             match record? {
                 BreakpadStackRecord::Cfi(r) => {
                     writeln!(
@@ -1204,9 +1257,339 @@ impl CfiCacheV1<'_> {
     }
 }
 
+/// The records, rules and address index of a CFI cache, built from Breakpad ASCII text.
+#[derive(Default)]
+struct CfiIndexBuilder {
+    records: Vec<raw::Record>,
+    rows: Vec<raw::Row>,
+    string_table: watto::StringTable,
+}
+
+impl CfiIndexBuilder {
+    /// Collects all stack records from the given Breakpad ASCII text.
+    fn from_text(text: &[u8]) -> Result<Self, CfiError> {
+        let mut builder = Self::default();
+
+        for line in text.split(|b| *b == b'\n') {
+            if line.starts_with(b"STACK CFI INIT ") {
+                let record = BreakpadStackCfiRecord::parse(line)?;
+                builder.push_record(
+                    record.start,
+                    record.size,
+                    raw::RECORD_CFI,
+                    record.init_rules,
+                );
+            } else if line.starts_with(b"STACK CFI ") {
+                let delta = BreakpadStackCfiDeltaRecord::parse(line)?;
+                builder.push_row(delta.address, delta.rules);
+            } else if let Some(rules) = line.strip_prefix(b"STACK WIN ") {
+                let record = BreakpadStackWinRecord::parse(line)?;
+                let rules = std::str::from_utf8(rules).map_err(BreakpadError::from)?;
+                builder.push_record(
+                    record.code_start.into(),
+                    record.code_size.into(),
+                    raw::RECORD_WIN,
+                    rules.trim(),
+                );
+            }
+        }
+
+        Ok(builder)
+    }
+
+    fn push_record(&mut self, start: u64, size: u64, kind: u32, rules: &str) {
+        self.records.push(raw::Record {
+            start,
+            size,
+            rules_offset: self.string_table.insert(rules) as u32,
+            kind,
+            first_row: self.rows.len() as u32,
+            num_rows: 0,
+        });
+    }
+
+    fn push_row(&mut self, addr: u64, rules: &str) {
+        // Delta records always follow a `STACK CFI INIT` record. Skip them otherwise.
+        let Some(record) = self.records.last_mut() else {
+            return;
+        };
+        if record.kind != raw::RECORD_CFI {
+            return;
+        }
+
+        record.num_rows += 1;
+        self.rows.push(raw::Row {
+            addr,
+            rules_offset: self.string_table.insert(rules) as u32,
+            _padding: 0,
+        });
+    }
+
+    /// Splits the address space into non-overlapping ranges, each covered by a single record.
+    ///
+    /// Records may overlap, for instance when frame data of a PDB describes a nested range within
+    /// a function. Where they do, the innermost record wins, that is the one with the highest start
+    /// address, and then the smallest size. Between records, ranges point to [`raw::NO_RECORD`].
+    fn build_ranges(&self) -> (Vec<raw::Range>, Vec<raw::RangeRecord>) {
+        let end = |record: &raw::Record| record.start.saturating_add(record.size);
+
+        let mut by_start: Vec<_> = (0..self.records.len() as u32)
+            .filter(|&idx| self.records[idx as usize].size > 0)
+            .collect();
+        by_start.sort_by_key(|&idx| self.records[idx as usize].start);
+
+        let mut by_end = by_start.clone();
+        by_end.sort_by_key(|&idx| end(&self.records[idx as usize]));
+
+        let mut boundaries: Vec<_> = self
+            .records
+            .iter()
+            .filter(|record| record.size > 0)
+            .flat_map(|record| [record.start, end(record)])
+            .collect();
+        boundaries.sort_unstable();
+        boundaries.dedup();
+
+        let mut active = BTreeSet::new();
+        let mut starts = by_start.into_iter().peekable();
+        let mut ends = by_end.into_iter().peekable();
+
+        let mut ranges = Vec::new();
+        let mut range_records = Vec::new();
+
+        for addr in boundaries {
+            while let Some(idx) = ends.next_if(|&idx| end(&self.records[idx as usize]) <= addr) {
+                let record = &self.records[idx as usize];
+                active.remove(&(record.start, Reverse(end(record)), idx));
+            }
+            while let Some(idx) = starts.next_if(|&idx| self.records[idx as usize].start <= addr) {
+                let record = &self.records[idx as usize];
+                active.insert((record.start, Reverse(end(record)), idx));
+            }
+
+            let record_idx = active.last().map_or(raw::NO_RECORD, |&(_, _, idx)| idx);
+            if range_records.last().map(|r: &raw::RangeRecord| r.0) != Some(record_idx) {
+                ranges.push(raw::Range(addr));
+                range_records.push(raw::RangeRecord(record_idx));
+            }
+        }
+
+        (ranges, range_records)
+    }
+
+    /// Writes the binary index, preceded by the given text.
+    fn serialize<W: Write>(self, text: &[u8], writer: W) -> Result<(), io::Error> {
+        let (ranges, range_records) = self.build_ranges();
+        let string_bytes = self.string_table.into_bytes();
+
+        let header = raw::Header {
+            text_len: text.len() as u64,
+            num_records: self.records.len() as u32,
+            num_rows: self.rows.len() as u32,
+            num_ranges: ranges.len() as u32,
+            string_bytes: string_bytes.len() as u32,
+            _reserved: [0; 8],
+        };
+
+        let mut writer = Writer::new(writer);
+        writer.write_all(&CFICACHE_MAGIC.to_ne_bytes())?;
+        writer.write_all(&CFICACHE_LATEST_VERSION.to_ne_bytes())?;
+        writer.write_all(header.as_bytes())?;
+        writer.write_all(text)?;
+        writer.align_to(8)?;
+
+        writer.write_all(self.records.as_bytes())?;
+        writer.align_to(8)?;
+
+        writer.write_all(self.rows.as_bytes())?;
+        writer.align_to(8)?;
+
+        writer.write_all(ranges.as_bytes())?;
+        writer.align_to(8)?;
+
+        writer.write_all(range_records.as_bytes())?;
+        writer.align_to(8)?;
+
+        writer.write_all(&string_bytes)?;
+
+        Ok(())
+    }
+}
+
+/// A parsed view of the binary index of a CFI cache, see the [`raw`] module.
+struct CfiIndex<'a> {
+    text: &'a [u8],
+    records: &'a [raw::Record],
+    rows: &'a [raw::Row],
+    ranges: &'a [raw::Range],
+    range_records: &'a [raw::RangeRecord],
+    string_bytes: &'a [u8],
+}
+
+impl<'a> CfiIndex<'a> {
+    /// Parses the index from a buffer starting right after the preamble.
+    fn parse(buf: &'a [u8]) -> Option<Self> {
+        let (header, rest) = raw::Header::ref_from_prefix(buf)?;
+
+        let text_len = usize::try_from(header.text_len).ok()?;
+        let text = rest.get(..text_len)?;
+        let rest = &rest[text_len..];
+
+        let (_, rest) = align_to(rest, 8)?;
+        let (records, rest) = raw::Record::slice_from_prefix(rest, header.num_records as usize)?;
+
+        let (_, rest) = align_to(rest, 8)?;
+        let (rows, rest) = raw::Row::slice_from_prefix(rest, header.num_rows as usize)?;
+
+        let (_, rest) = align_to(rest, 8)?;
+        let (ranges, rest) = raw::Range::slice_from_prefix(rest, header.num_ranges as usize)?;
+
+        let (_, rest) = align_to(rest, 8)?;
+        let (range_records, rest) =
+            raw::RangeRecord::slice_from_prefix(rest, header.num_ranges as usize)?;
+
+        let (_, rest) = align_to(rest, 8)?;
+        let string_bytes = rest.get(..header.string_bytes as usize)?;
+
+        Some(CfiIndex {
+            text,
+            records,
+            rows,
+            ranges,
+            range_records,
+            string_bytes,
+        })
+    }
+
+    fn lookup(&self, addr: u64) -> Option<CfiRecord<'a>> {
+        let range_idx = self.ranges.partition_point(|range| range.0 <= addr);
+        let record_idx = self.range_records.get(range_idx.checked_sub(1)?)?.0;
+        let record = self.records.get(record_idx as usize)?;
+
+        let kind = match record.kind {
+            raw::RECORD_CFI => CfiRecordKind::Cfi,
+            raw::RECORD_WIN => CfiRecordKind::Win,
+            _ => return None,
+        };
+
+        let first_row = record.first_row as usize;
+        let rows = self
+            .rows
+            .get(first_row..first_row + record.num_rows as usize)
+            .unwrap_or_default();
+
+        Some(CfiRecord {
+            kind,
+            start: record.start,
+            size: record.size,
+            rules: watto::StringTable::read(self.string_bytes, record.rules_offset as usize)
+                .ok()?,
+            deltas: CfiDeltas {
+                addr,
+                rows: rows.iter(),
+                string_bytes: self.string_bytes,
+            },
+        })
+    }
+}
+
+struct CfiCacheV3<'a> {
+    byteview: ByteView<'a>,
+}
+
+impl CfiCacheV3<'_> {
+    fn index(&self) -> CfiIndex<'_> {
+        // The index has been validated in `CfiCache::from_bytes`.
+        CfiIndex::parse(&self.byteview[8..]).unwrap()
+    }
+}
+
 enum CfiCacheInner<'a> {
     Unversioned(CfiCacheV1<'a>),
     Versioned(u32, CfiCacheV1<'a>),
+    Indexed(CfiCacheV3<'a>),
+}
+
+/// The kind of a [`CfiRecord`].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum CfiRecordKind {
+    /// A `STACK CFI INIT` record, with the `STACK CFI` records that follow it.
+    Cfi,
+    /// A `STACK WIN` record, used for Windows x86.
+    Win,
+}
+
+/// The stack record covering an address, returned by [`CfiCache::lookup`].
+#[derive(Clone, Debug)]
+pub struct CfiRecord<'a> {
+    kind: CfiRecordKind,
+    start: u64,
+    size: u64,
+    rules: &'a str,
+    deltas: CfiDeltas<'a>,
+}
+
+impl<'a> CfiRecord<'a> {
+    /// The kind of this record.
+    pub fn kind(&self) -> CfiRecordKind {
+        self.kind
+    }
+
+    /// The first address covered by this record.
+    pub fn start(&self) -> u64 {
+        self.start
+    }
+
+    /// The number of bytes covered by this record.
+    pub fn size(&self) -> u64 {
+        self.size
+    }
+
+    /// The rules of this record.
+    ///
+    /// For [`CfiRecordKind::Cfi`], these are the rules of the `STACK CFI INIT` record. For
+    /// [`CfiRecordKind::Win`], this is the entire `STACK WIN` record without the `STACK WIN`
+    /// prefix.
+    pub fn rules(&self) -> &'a str {
+        self.rules
+    }
+
+    /// Returns an iterator over the `STACK CFI` records that apply at the looked up address.
+    ///
+    /// These are all delta records of this record at or before the looked up address, in the
+    /// order they must be applied to [`rules`](Self::rules).
+    pub fn deltas(&self) -> CfiDeltas<'a> {
+        self.deltas.clone()
+    }
+}
+
+/// An iterator over the `STACK CFI` delta records of a [`CfiRecord`].
+///
+/// Yields the address and the rules of each delta record.
+#[derive(Clone, Debug)]
+pub struct CfiDeltas<'a> {
+    addr: u64,
+    rows: std::slice::Iter<'a, raw::Row>,
+    string_bytes: &'a [u8],
+}
+
+impl<'a> Iterator for CfiDeltas<'a> {
+    type Item = (u64, &'a str);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        for row in self.rows.by_ref() {
+            if row.addr > self.addr {
+                continue;
+            }
+            if let Ok(rules) =
+                watto::StringTable::read(self.string_bytes, row.rules_offset as usize)
+            {
+                return Some((row.addr, rules));
+            }
+        }
+
+        None
+    }
 }
 
 /// A cache file for call frame information (CFI).
@@ -1239,6 +1622,29 @@ enum CfiCacheInner<'a> {
 /// # Ok(())
 /// # }
 /// ```
+///
+/// Since version 3, the cache also contains a binary address index. It allows to look up the
+/// unwind rules for a single address with [`lookup`](Self::lookup), without parsing the text.
+/// The index stores the same records as the text, so it roughly doubles the size of the cache,
+/// depending on how many rules repeat. Caches that are only used for lookups can leave out the
+/// text with [`from_object_without_text`](Self::from_object_without_text):
+///
+/// ```rust,no_run
+/// use symbolic_common::ByteView;
+/// use symbolic_cfi::CfiCache;
+///
+/// # fn main() -> Result<(), Box<dyn std::error::Error>> {
+/// let view = ByteView::open("my.cficache")?;
+/// let cache = CfiCache::from_bytes(view)?;
+/// if let Some(record) = cache.lookup(0x1000) {
+///     println!("{}", record.rules());
+///     for (address, rules) in record.deltas() {
+///         println!("{address:#x}: {rules}");
+///     }
+/// }
+/// # Ok(())
+/// # }
+/// ```
 pub struct CfiCache<'a> {
     inner: CfiCacheInner<'a>,
 }
@@ -1246,14 +1652,25 @@ pub struct CfiCache<'a> {
 impl CfiCache<'static> {
     /// Construct a CFI cache from an `Object`.
     pub fn from_object(object: &Object<'_>) -> Result<Self, CfiError> {
-        let mut buffer = vec![];
-        write_preamble(&mut buffer, CFICACHE_LATEST_VERSION)?;
+        Self::build(object, true)
+    }
+
+    /// Construct a CFI cache from an `Object` that only contains the binary address index.
+    ///
+    /// Such a cache supports [`lookup`](Self::lookup), but [`as_slice`](Self::as_slice) returns
+    /// an empty slice, so it cannot be passed to consumers of the Breakpad text.
+    pub fn from_object_without_text(object: &Object<'_>) -> Result<Self, CfiError> {
+        Self::build(object, false)
+    }
+
+    fn build(object: &Object<'_>, include_text: bool) -> Result<Self, CfiError> {
+        let mut text = vec![];
 
         if let Object::Pe(pe) = object {
             let debug_file = pe.debug_file_name();
             if let Some(debug_file) = debug_file {
                 writeln!(
-                    buffer,
+                    text,
                     "MODULE windows {} {} {debug_file}",
                     object.arch().name(),
                     object.debug_id().breakpad(),
@@ -1261,10 +1678,18 @@ impl CfiCache<'static> {
             }
         }
 
-        AsciiCfiWriter::new(&mut buffer).process(object)?;
+        AsciiCfiWriter::new(&mut text).process(object)?;
+
+        let index = CfiIndexBuilder::from_text(&text)?;
+        if !include_text {
+            text.clear();
+        }
+
+        let mut buffer = vec![];
+        index.serialize(&text, &mut buffer)?;
 
         let byteview = ByteView::from_vec(buffer);
-        let inner = CfiCacheInner::Versioned(CFICACHE_LATEST_VERSION, CfiCacheV1 { byteview });
+        let inner = CfiCacheInner::Indexed(CfiCacheV3 { byteview });
         Ok(CfiCache { inner })
     }
 }
@@ -1286,6 +1711,14 @@ impl<'a> CfiCache<'a> {
             let magic = u32::from_ne_bytes(preamble[0..4].try_into().unwrap());
             if magic == CFICACHE_MAGIC {
                 let version = u32::from_ne_bytes(preamble[4..8].try_into().unwrap());
+                if version == 3 {
+                    if CfiIndex::parse(&byteview[8..]).is_none() {
+                        return Err(CfiErrorKind::BadCacheFile.into());
+                    }
+                    let inner = CfiCacheInner::Indexed(CfiCacheV3 { byteview });
+                    return Ok(CfiCache { inner });
+                }
+
                 let inner = CfiCacheInner::Versioned(version, CfiCacheV1 { byteview });
                 return Ok(CfiCache { inner });
             }
@@ -1299,6 +1732,7 @@ impl<'a> CfiCache<'a> {
         match self.inner {
             CfiCacheInner::Unversioned(_) => 1,
             CfiCacheInner::Versioned(version, _) => version,
+            CfiCacheInner::Indexed(_) => 3,
         }
     }
 
@@ -1308,20 +1742,43 @@ impl<'a> CfiCache<'a> {
     }
 
     /// Returns the raw buffer of the cache file.
+    ///
+    /// This is the Breakpad ASCII text of all stack records, without the preamble and, since
+    /// version 3, without the binary index. The slice is empty for caches created with
+    /// [`from_object_without_text`](CfiCache::from_object_without_text).
     pub fn as_slice(&self) -> &[u8] {
         match self.inner {
             CfiCacheInner::Unversioned(ref v1) => v1.raw(),
             CfiCacheInner::Versioned(_, ref v1) => &v1.raw()[8..],
+            CfiCacheInner::Indexed(ref v3) => v3.index().text,
+        }
+    }
+
+    /// Looks up the stack record covering the given address.
+    ///
+    /// The lookup uses the binary address index of the cache. It only touches the parts of the file
+    /// needed for this address, which makes it well suited for memory mapped caches.
+    ///
+    /// Returns `None` if no record covers the address, or if this cache was written before version
+    /// 3 and does not contain an index. Such caches should be regenerated, see
+    /// [`is_latest`](Self::is_latest).
+    pub fn lookup(&self, addr: u64) -> Option<CfiRecord<'_>> {
+        match self.inner {
+            CfiCacheInner::Indexed(ref v3) => v3.index().lookup(addr),
+            _ => None,
         }
     }
 
     /// Writes the cache to the given writer.
     pub fn write_to<W: Write>(&self, mut writer: W) -> Result<(), io::Error> {
-        if let CfiCacheInner::Versioned(version, _) = self.inner {
-            write_preamble(&mut writer, version)?;
+        match self.inner {
+            CfiCacheInner::Indexed(ref v3) => writer.write_all(&v3.byteview),
+            CfiCacheInner::Versioned(version, _) => {
+                write_preamble(&mut writer, version)?;
+                writer.write_all(self.as_slice())
+            }
+            CfiCacheInner::Unversioned(_) => writer.write_all(self.as_slice()),
         }
-        io::copy(&mut self.as_slice(), &mut writer)?;
-        Ok(())
     }
 }
 
@@ -0,0 +1,114 @@
+//! The raw binary CfiCache file format internals.
+//!
+//! Starting with version 3, a CfiCache contains a binary index after the preamble:
+//!
+//! - A [`Header`], followed by the Breakpad ASCII text of all stack records. The text is empty
+//!   if the cache was created without it.
+//! - A list of [`Record`]s, one for each `STACK CFI INIT` or `STACK WIN` record in the text.
+//! - A list of [`Row`]s, containing the `STACK CFI` delta records of all records.
+//! - A sorted list of non-overlapping address [`Range`]s, followed by the index of the record that
+//!   covers each range, see [`RangeRecord`].
+//! - A string table containing the deduplicated rules of all records and rows.
+//!
+//! All lists are aligned to 8 bytes.
+
+use watto::Pod;
+
+/// The record index of a [`Range`] that is not covered by any record.
+pub(crate) const NO_RECORD: u32 = u32::MAX;
+
+/// The kind of a [`Record`] created from a `STACK CFI INIT` record.
+pub(crate) const RECORD_CFI: u32 = 0;
+/// The kind of a [`Record`] created from a `STACK WIN` record.
+pub(crate) const RECORD_WIN: u32 = 1;
+
+/// The header of the binary index, following the preamble.
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct Header {
+    /// Number of bytes of Breakpad ASCII text following the header.
+    pub(crate) text_len: u64,
+    /// Number of included [`Record`]s.
+    pub(crate) num_records: u32,
+    /// Number of included [`Row`]s.
+    pub(crate) num_rows: u32,
+    /// Number of included [`Range`]s.
+    pub(crate) num_ranges: u32,
+    /// Total number of bytes used for string data.
+    pub(crate) string_bytes: u32,
+
+    /// Some reserved space in the header for future extensions.
+    pub(crate) _reserved: [u8; 8],
+}
+
+/// A `STACK CFI INIT` or `STACK WIN` record.
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct Record {
+    /// The first address covered by this record.
+    pub(crate) start: u64,
+    /// The number of bytes covered by this record.
+    pub(crate) size: u64,
+    /// The rules of this record (reference to a string).
+    pub(crate) rules_offset: u32,
+    /// Either [`RECORD_CFI`] or [`RECORD_WIN`].
+    pub(crate) kind: u32,
+    /// The index of the first [`Row`] belonging to this record.
+    pub(crate) first_row: u32,
+    /// The number of [`Row`]s belonging to this record.
+    pub(crate) num_rows: u32,
+}
+
+/// A `STACK CFI` delta record.
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct Row {
+    /// The address from which these rules apply.
+    pub(crate) addr: u64,
+    /// The rules of this row (reference to a string).
+    pub(crate) rules_offset: u32,
+    pub(crate) _padding: u32,
+}
+
+/// The start address of a range in the address index.
+///
+/// The end is implicitly given by the next range's start.
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct Range(pub(crate) u64);
+
+/// The index of the [`Record`] covering the [`Range`] at the same position, or [`NO_RECORD`].
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct RangeRecord(pub(crate) u32);
+
+unsafe impl Pod for Header {}
+unsafe impl Pod for Record {}
+unsafe impl Pod for Row {}
+unsafe impl Pod for Range {}
+unsafe impl Pod for RangeRecord {}
+
+#[cfg(test)]
+mod tests {
+    use std::mem;
+
+    use super::*;
+
+    #[test]
+    fn test_sizeof() {
+        assert_eq!(mem::size_of::<Header>(), 32);
+        assert_eq!(mem::align_of::<Header>(), 8);
+
+        assert_eq!(mem::size_of::<Record>(), 32);
+        assert_eq!(mem::align_of::<Record>(), 8);
+
+        assert_eq!(mem::size_of::<Row>(), 16);
+        assert_eq!(mem::align_of::<Row>(), 8);
+
+        assert_eq!(mem::size_of::<Range>(), 8);
+        assert_eq!(mem::align_of::<Range>(), 8);
+
+        assert_eq!(mem::size_of::<RangeRecord>(), 4);
+        assert_eq!(mem::align_of::<RangeRecord>(), 4);
+    }
+}
@@ -1,9 +1,9 @@
 use std::str;
 
-use symbolic_cfi::{AsciiCfiWriter, CfiCache};
+use symbolic_cfi::{AsciiCfiWriter, CfiCache, CfiRecordKind, CFICACHE_LATEST_VERSION};
 use symbolic_common::ByteView;
 use symbolic_debuginfo::Object;
-use symbolic_testutils::fixture;
+use symbolic_testutils::{fixture, large_breakpad_file};
 
 use similar_asserts::assert_eq;
 
@@ -83,6 +83,27 @@ fn cfi_from_sym_windows() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn cfi_from_sym_parallel() -> Result<(), Error> {
+    for file in ["macos/crash.sym", "windows/crash.sym"] {
+        let data = large_breakpad_file(file, 10);
+        let object = Object::parse(&data)?;
+        let expected: Vec<u8> = AsciiCfiWriter::transform(&object)?;
+
+        for threads in [2, 3, 8] {
+            let mut writer = AsciiCfiWriter::new(Vec::new());
+            writer.set_threads(threads);
+            writer.process(&object)?;
+            assert_eq!(
+                str::from_utf8(&writer.into_inner())?,
+                str::from_utf8(&expected)?
+            );
+        }
+    }
+
+    Ok(())
+}
+
 #[test]
 fn cfi_from_pdb_windows() -> Result<(), Error> {
     let buffer = ByteView::open(fixture("windows/crash.pdb"))?;
@@ -106,3 +127,135 @@ fn cfi_from_pe_windows() -> Result<(), Error> {
 
     Ok(())
 }
+
+#[test]
+fn cfi_cache_roundtrip() -> Result<(), Error> {
+    let buffer = ByteView::open(fixture("linux/crash"))?;
+    let object = Object::parse(&buffer)?;
+
+    let cache = CfiCache::from_object(&object)?;
+    assert_eq!(cache.version(), CFICACHE_LATEST_VERSION);
+
+    let text: Vec<u8> = AsciiCfiWriter::transform(&object)?;
+    assert_eq!(cache.as_slice(), &text[..]);
+
+    let mut written = Vec::new();
+    cache.write_to(&mut written)?;
+    let loaded = CfiCache::from_bytes(ByteView::from_vec(written))?;
+    assert!(loaded.is_latest());
+    assert_eq!(loaded.as_slice(), &text[..]);
+
+    let mut truncated = Vec::new();
+    cache.write_to(&mut truncated)?;
+    truncated.truncate(truncated.len() - 1);
+    assert!(CfiCache::from_bytes(ByteView::from_vec(truncated)).is_err());
+
+    Ok(())
+}
+
+#[test]
+fn cfi_cache_lookup() -> Result<(), Error> {
+    let buffer = ByteView::open(fixture("linux/crash"))?;
+    let object = Object::parse(&buffer)?;
+    let cache = CfiCache::from_object(&object)?;
+
+    let text = str::from_utf8(cache.as_slice())?;
+    let mut lines = text.lines().peekable();
+    let mut records = 0;
+
+    while let Some(line) = lines.next() {
+        let Some(init) = line.strip_prefix("STACK CFI INIT ") else {
+            continue;
+        };
+        let mut parts = init.splitn(3, ' ');
+        let start = u64::from_str_radix(parts.next().unwrap(), 16)?;
+        let size = u64::from_str_radix(parts.next().unwrap(), 16)?;
+        let rules = parts.next().unwrap();
+
+        let mut deltas = Vec::new();
+        while let Some(delta) = lines.next_if(|line| !line.starts_with("STACK CFI INIT ")) {
+            let (address, rules) = delta
+                .strip_prefix("STACK CFI ")
+                .unwrap()
+                .split_once(' ')
+                .unwrap();
+            deltas.push((u64::from_str_radix(address, 16)?, rules));
+        }
+
+        for addr in [start, start + size / 2, start + size - 1] {
+            let record = cache.lookup(addr).expect("record");
+            assert_eq!(record.kind(), CfiRecordKind::Cfi);
+            assert_eq!(record.start(), start);
+            assert_eq!(record.size(), size);
+            assert_eq!(record.rules(), rules);
+
+            let expected: Vec<_> = deltas.iter().filter(|d| d.0 <= addr).copied().collect();
+            assert_eq!(record.deltas().collect::<Vec<_>>(), expected);
+        }
+
+        records += 1;
+    }
+
+    assert!(records > 0);
+    assert!(cache.lookup(0).is_none());
+    assert!(cache.lookup(u64::MAX).is_none());
+
+    Ok(())
+}
+
+#[test]
+fn cfi_cache_without_text() -> Result<(), Error> {
+    let buffer = ByteView::open(fixture("linux/crash"))?;
+    let object = Object::parse(&buffer)?;
+    let full = CfiCache::from_object(&object)?;
+    let cache = CfiCache::from_object_without_text(&object)?;
+    assert!(cache.as_slice().is_empty());
+
+    let mut full_bytes = Vec::new();
+    full.write_to(&mut full_bytes)?;
+    let mut written = Vec::new();
+    cache.write_to(&mut written)?;
+    assert!(written.len() + full.as_slice().len() <= full_bytes.len());
+
+    let loaded = CfiCache::from_bytes(ByteView::from_vec(written))?;
+    assert!(loaded.is_latest());
+    assert!(loaded.as_slice().is_empty());
+
+    let text = str::from_utf8(full.as_slice())?;
+    for line in text.lines() {
+        let Some(init) = line.strip_prefix("STACK CFI INIT ") else {
+            continue;
+        };
+        let addr = u64::from_str_radix(init.split(' ').next().unwrap(), 16)?;
+        let expected = full.lookup(addr).expect("record");
+        let record = loaded.lookup(addr).expect("record");
+        assert_eq!(record.start(), expected.start());
+        assert_eq!(record.rules(), expected.rules());
+        assert!(record.deltas().eq(expected.deltas()));
+    }
+
+    Ok(())
+}
+
+#[test]
+fn cfi_cache_lookup_win() -> Result<(), Error> {
+    let buffer = ByteView::open(fixture("windows/crash.pdb"))?;
+    let object = Object::parse(&buffer)?;
+    let cache = CfiCache::from_object(&object)?;
+
+    let record = cache.lookup(0x1000).expect("record");
+    assert_eq!(record.kind(), CfiRecordKind::Win);
+    assert_eq!(record.start(), 0x1000);
+    assert_eq!(record.size(), 0x114);
+    assert_eq!(
+        record.rules(),
+        "4 1000 114 11 0 8 0 0 0 1 $T0 .raSearch = $eip $T0 ^ = $esp $T0 4 + ="
+    );
+    assert_eq!(record.deltas().count(), 0);
+
+    // Frame data of nested ranges takes precedence over the enclosing function.
+    let record = cache.lookup(0x1010).expect("record");
+    assert_eq!(record.start(), 0x100f);
+
+    Ok(())
+}
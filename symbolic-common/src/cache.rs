@@ -0,0 +1,311 @@
+//! A bounded cache that can be shared between threads.
+
+use std::borrow::Borrow;
+use std::collections::hash_map::RandomState;
+use std::collections::HashMap;
+use std::hash::{BuildHasher, Hash};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+
+/// The number of independently locked shards.
+const SHARD_COUNT: usize = 16;
+
+/// Statistics of a [`ShardedCache`].
+#[derive(Clone, Copy, Debug, Default, Eq, PartialEq)]
+pub struct ShardedCacheStats {
+    /// The number of lookups that were answered from the cache.
+    pub hits: u64,
+    /// The number of lookups that did not find an entry.
+    pub misses: u64,
+    /// The number of entries that were evicted to stay within the size budget.
+    pub evictions: u64,
+    /// The number of entries currently in the cache.
+    pub entries: usize,
+    /// The approximate size of all cached entries in bytes.
+    pub bytes: usize,
+}
+
+#[derive(Debug)]
+struct Entry<V> {
+    value: V,
+    size: usize,
+    referenced: bool,
+}
+
+#[derive(Debug)]
+struct Shard<K, V> {
+    entries: HashMap<K, Entry<V>>,
+    bytes: usize,
+}
+
+impl<K, V> Default for Shard<K, V> {
+    fn default() -> Self {
+        Self {
+            entries: HashMap::new(),
+            bytes: 0,
+        }
+    }
+}
+
+impl<K: Hash + Eq, V> Shard<K, V> {
+    /// Evicts entries other than `keep` until the shard is at or below `target` bytes.
+    ///
+    /// Entries that were hit since the previous sweep get a second chance: the first pass only
+    /// clears their referenced flag, and they are evicted in the second pass if that is still not
+    /// enough. `keep` is the entry that was just inserted. It has not had a chance to be hit yet,
+    /// so it would otherwise be the first one to go. Returns the number of evicted entries.
+    fn evict(&mut self, target: usize, keep: &K) -> u64 {
+        let mut evicted = 0;
+
+        for second_chance in [true, false] {
+            self.entries.retain(|key, entry| {
+                if self.bytes <= target || key == keep {
+                    return true;
+                }
+                if second_chance && entry.referenced {
+                    entry.referenced = false;
+                    return true;
+                }
+                self.bytes -= entry.size;
+                evicted += 1;
+                false
+            });
+        }
+
+        evicted
+    }
+}
+
+/// A bounded, concurrent cache, split into independently locked shards.
+///
+/// Every entry is inserted with its approximate size in bytes. Once a shard exceeds its part of
+/// the budget, it evicts entries down to three quarters of that, so that the sweep is amortized
+/// over many insertions. Eviction prefers entries that have not been hit since the previous
+/// sweep, and never evicts the entry that is being inserted.
+///
+/// Values are cloned out of the cache, so large values should be wrapped in an
+/// [`Arc`](std::sync::Arc).
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::ShardedCache;
+///
+/// let cache = ShardedCache::new(1024);
+/// assert!(cache.insert(String::from("answer"), 42, 8));
+/// assert_eq!(cache.get("answer"), Some(42));
+/// assert_eq!(cache.get("question"), None);
+///
+/// let stats = cache.stats();
+/// assert_eq!((stats.hits, stats.misses, stats.entries), (1, 1, 1));
+/// ```
+#[derive(Debug)]
+pub struct ShardedCache<K, V, S = RandomState> {
+    shards: Box<[Mutex<Shard<K, V>>]>,
+    shard_budget: usize,
+    hasher: S,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl<K, V> ShardedCache<K, V> {
+    /// Creates a new cache that holds approximately `budget` bytes of entries.
+    pub fn new(budget: usize) -> Self {
+        Self::with_hasher(budget, RandomState::new())
+    }
+}
+
+impl<K, V, S> ShardedCache<K, V, S> {
+    /// Creates a new cache that uses `hasher` to distribute keys across shards.
+    pub fn with_hasher(budget: usize, hasher: S) -> Self {
+        Self {
+            shards: (0..SHARD_COUNT).map(|_| Mutex::default()).collect(),
+            shard_budget: budget / SHARD_COUNT,
+            hasher,
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// Returns hit, miss and eviction counters, as well as the current size of the cache.
+    pub fn stats(&self) -> ShardedCacheStats {
+        let mut stats = ShardedCacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            ..Default::default()
+        };
+
+        for shard in self.shards.iter() {
+            let shard = shard.lock().unwrap();
+            stats.entries += shard.entries.len();
+            stats.bytes += shard.bytes;
+        }
+
+        stats
+    }
+
+    /// Removes all entries from the cache, keeping the counters.
+    pub fn clear(&self) {
+        for shard in self.shards.iter() {
+            *shard.lock().unwrap() = Shard::default();
+        }
+    }
+}
+
+impl<K, V, S> ShardedCache<K, V, S>
+where
+    K: Hash + Eq,
+    V: Clone,
+    S: BuildHasher,
+{
+    fn shard<Q: Hash + ?Sized>(&self, key: &Q) -> &Mutex<Shard<K, V>> {
+        &self.shards[self.hasher.hash_one(key) as usize % SHARD_COUNT]
+    }
+
+    /// Returns a clone of the value for `key`, if it is in the cache.
+    pub fn get<Q>(&self, key: &Q) -> Option<V>
+    where
+        K: Borrow<Q>,
+        Q: Hash + Eq + ?Sized,
+    {
+        let mut shard = self.shard(key).lock().unwrap();
+        let Some(entry) = shard.entries.get_mut(key) else {
+            self.misses.fetch_add(1, Ordering::Relaxed);
+            return None;
+        };
+
+        entry.referenced = true;
+        self.hits.fetch_add(1, Ordering::Relaxed);
+        Some(entry.value.clone())
+    }
+
+    /// Inserts a value of approximately `size` bytes, replacing any previous value for `key`.
+    ///
+    /// Returns `false` if the value is too large to be cached at all.
+    pub fn insert(&self, key: K, value: V, size: usize) -> bool {
+        if size > self.shard_budget {
+            return false;
+        }
+
+        let mut shard = self.shard(&key).lock().unwrap();
+        shard.bytes += size;
+        if shard.bytes > self.shard_budget {
+            let evicted = shard.evict(self.shard_budget / 4 * 3, &key);
+            self.evictions.fetch_add(evicted, Ordering::Relaxed);
+        }
+
+        let entry = Entry {
+            value,
+            size,
+            referenced: false,
+        };
+        if let Some(previous) = shard.entries.insert(key, entry) {
+            shard.bytes -= previous.size;
+        }
+
+        true
+    }
+
+    /// Removes the value for `key` from the cache.
+    pub fn remove<Q>(&self, key: &Q) -> Option<V>
+    where
+        K: Borrow<Q>,
+        Q: Hash + Eq + ?Sized,
+    {
+        let mut shard = self.shard(key).lock().unwrap();
+        let entry = shard.entries.remove(key)?;
+        shard.bytes -= entry.size;
+        Some(entry.value)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::hash::{BuildHasherDefault, Hasher};
+
+    use super::*;
+
+    /// Hashes every key to zero, so that all entries end up in the same shard.
+    #[derive(Default)]
+    struct ZeroHasher;
+
+    impl Hasher for ZeroHasher {
+        fn finish(&self) -> u64 {
+            0
+        }
+
+        fn write(&mut self, _bytes: &[u8]) {}
+    }
+
+    fn single_shard(shard_budget: usize) -> ShardedCache<u32, u32, BuildHasherDefault<ZeroHasher>> {
+        ShardedCache::with_hasher(shard_budget * SHARD_COUNT, Default::default())
+    }
+
+    #[test]
+    fn test_budget() {
+        let cache = ShardedCache::new(SHARD_COUNT * 1024);
+        for i in 0..1000u32 {
+            assert!(cache.insert(i, i, 100));
+        }
+
+        let stats = cache.stats();
+        assert!(stats.evictions > 0);
+        assert!(stats.bytes <= SHARD_COUNT * 1024);
+        assert_eq!(stats.entries as u64, 1000 - stats.evictions);
+
+        // Values larger than a shard's budget are not cached.
+        assert!(!cache.insert(1000, 1000, 1025));
+        assert_eq!(cache.get(&1000), None);
+
+        cache.clear();
+        assert_eq!(cache.stats().entries, 0);
+    }
+
+    #[test]
+    fn test_insert_survives_hot_shard() {
+        let cache = single_shard(400);
+        for i in 0..4 {
+            cache.insert(i, i, 100);
+            assert_eq!(cache.get(&i), Some(i));
+        }
+
+        // All other entries are hot, so the sweep has to evict one of them, not the new entry.
+        cache.insert(4, 4, 100);
+        assert_eq!(cache.get(&4), Some(4));
+
+        let stats = cache.stats();
+        assert_eq!(stats.entries, 3);
+        assert_eq!(stats.bytes, 300);
+        assert_eq!(stats.evictions, 2);
+    }
+
+    #[test]
+    fn test_second_chance() {
+        let cache = single_shard(400);
+        for i in 0..4 {
+            cache.insert(i, i, 100);
+        }
+
+        // Only the hot entry and the new one survive a sweep down to 300 bytes.
+        cache.get(&2);
+        cache.insert(4, 4, 200);
+        assert_eq!(cache.get(&2), Some(2));
+        assert_eq!(cache.get(&4), Some(4));
+        assert_eq!(cache.stats().entries, 2);
+    }
+
+    #[test]
+    fn test_replace() {
+        let cache = single_shard(400);
+        cache.insert(1, 1, 100);
+        cache.insert(1, 2, 50);
+        assert_eq!(cache.get(&1), Some(2));
+        assert_eq!(cache.stats().bytes, 50);
+
+        assert_eq!(cache.remove(&1), Some(2));
+        assert_eq!(cache.stats().bytes, 0);
+    }
+}
@@ -23,16 +23,22 @@
 #![warn(missing_docs)]
 
 mod byteview;
+mod cache;
 mod cell;
 mod heuristics;
+mod parallel;
 mod path;
+mod search;
 mod sourcelinks;
 mod types;
 
 pub use crate::byteview::*;
+pub use crate::cache::*;
 pub use crate::cell::*;
 pub use crate::heuristics::*;
+pub use crate::parallel::*;
 pub use crate::path::*;
+pub use crate::search::*;
 pub use crate::sourcelinks::*;
 pub use crate::types::*;
 
@@ -0,0 +1,375 @@
+//! Helpers to spread work across threads.
+
+use std::collections::VecDeque;
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard, PoisonError};
+use std::thread::Scope;
+
+/// The number of chunks of work to create per thread.
+///
+/// Splitting the work into more chunks than threads balances chunks that take longer to process.
+/// [`ParallelIter::new`] also uses it to bound the number of results that are buffered at once.
+pub const CHUNKS_PER_THREAD: usize = 4;
+
+/// Applies `f` to every item on up to `threads` threads, and returns the results in the order of
+/// `items`.
+///
+/// Items are handed out to threads as they become idle, so items should be chunks of work that are
+/// substantially more expensive than the synchronization around them; see
+/// [`CHUNKS_PER_THREAD`]. With a single thread or item, `f` is called on the current thread.
+///
+/// If `f` panics, the panic is resumed on the calling thread.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::parallel_map;
+///
+/// let squares = parallel_map(&[1, 2, 3, 4], 2, |x| x * x);
+/// assert_eq!(squares, [1, 4, 9, 16]);
+/// ```
+pub fn parallel_map<T, R, F>(items: &[T], threads: usize, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    F: Fn(&T) -> R + Sync,
+{
+    if threads.min(items.len()) <= 1 {
+        return items.iter().map(f).collect();
+    }
+
+    // All results are collected anyway, so there is no point in limiting how far workers get ahead.
+    std::thread::scope(|scope| {
+        let map = |index: usize| f(&items[index]);
+        ParallelIter::with_budget(scope, items.len(), threads, usize::MAX, |_| 0, map).collect()
+    })
+}
+
+/// The state shared between a [`ParallelIter`] and its workers.
+struct Shared<R> {
+    state: Mutex<State<R>>,
+    /// Signaled when a worker has finished an item.
+    ready: Condvar,
+    /// Signaled when the consumer has taken a result or stopped.
+    space: Condvar,
+    /// The maximum number of items that are claimed but not yet consumed.
+    window: usize,
+    /// The maximum weight of finished results before workers stop claiming items.
+    budget: usize,
+}
+
+struct State<R> {
+    /// The number of items handed out to workers.
+    claimed: usize,
+    /// The number of results taken by the consumer.
+    consumed: usize,
+    /// The results of items `consumed..claimed` along with their weight, or `None` while the item
+    /// is still being processed.
+    pending: VecDeque<Option<(std::thread::Result<R>, usize)>>,
+    /// The total weight of all finished results in `pending`.
+    weight: usize,
+    /// Set when the consumer is dropped.
+    stopped: bool,
+}
+
+fn wait<'a, T>(condvar: &Condvar, guard: MutexGuard<'a, T>) -> MutexGuard<'a, T> {
+    condvar.wait(guard).unwrap_or_else(PoisonError::into_inner)
+}
+
+impl<R> Shared<R> {
+    fn lock(&self) -> MutexGuard<'_, State<R>> {
+        self.state.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+
+    /// Claims the next item, waiting while the consumer is too far behind.
+    ///
+    /// Items are claimed under the same lock that tracks consumed results, so a worker never
+    /// claims an item outside of the window. The item the consumer waits for has always been
+    /// claimed already, which is why waiting here cannot deadlock.
+    fn claim(&self, len: usize) -> Option<usize> {
+        let mut state = self.lock();
+        loop {
+            if state.stopped || state.claimed >= len {
+                return None;
+            }
+
+            if state.claimed - state.consumed < self.window && state.weight <= self.budget {
+                break;
+            }
+
+            state = wait(&self.space, state);
+        }
+
+        let index = state.claimed;
+        state.claimed += 1;
+        state.pending.push_back(None);
+        Some(index)
+    }
+
+    fn finish(&self, index: usize, result: std::thread::Result<R>, weight: usize) {
+        let mut state = self.lock();
+        let offset = index - state.consumed;
+        state.pending[offset] = Some((result, weight));
+        state.weight += weight;
+        drop(state);
+
+        self.ready.notify_one();
+    }
+}
+
+/// An iterator over the results of a function applied to `0..len` on worker threads, in order.
+///
+/// Workers are spawned once on a [`std::thread::scope`] and pick up the next item as soon as
+/// they become idle, so a single expensive item does not hold up the other workers. Finished
+/// results are buffered until the iterator reaches them. To bound that buffer, workers stop
+/// claiming new items while the iterator is too far behind.
+///
+/// Dropping the iterator stops the workers after their current item. The iterator must be
+/// consumed or dropped before the end of the scope, which otherwise waits for the workers forever.
+/// If the function panics, the panic is resumed when the iterator reaches the item.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::ParallelIter;
+///
+/// let items = ["a", "bb", "ccc"];
+/// std::thread::scope(|scope| {
+///     let lengths: Vec<_> = ParallelIter::new(scope, items.len(), 2, |i| items[i].len()).collect();
+///     assert_eq!(lengths, [1, 2, 3]);
+/// });
+/// ```
+pub struct ParallelIter<R> {
+    shared: Arc<Shared<R>>,
+    next: usize,
+    len: usize,
+}
+
+impl<R: Send> ParallelIter<R> {
+    /// Applies `f` to `0..len` on `threads` workers spawned on `scope`.
+    ///
+    /// Workers get at most `threads * CHUNKS_PER_THREAD` items ahead of the iterator.
+    pub fn new<'scope, 'env, F>(
+        scope: &'scope Scope<'scope, 'env>,
+        len: usize,
+        threads: usize,
+        f: F,
+    ) -> Self
+    where
+        F: Fn(usize) -> R + Send + Sync + 'scope,
+        R: 'scope,
+    {
+        let window = threads.max(1).saturating_mul(CHUNKS_PER_THREAD);
+        Self::spawn(scope, len, threads, window, usize::MAX, f, |_| 0)
+    }
+
+    /// Applies `f` to `0..len` on `threads` workers spawned on `scope`, bounding buffered results
+    /// by their weight.
+    ///
+    /// Workers stop claiming items while the results waiting for the iterator weigh more than
+    /// `budget` in total, as measured by `weight`. Items that are already being processed are
+    /// still finished, so the buffer can exceed the budget by up to one result per thread.
+    pub fn with_budget<'scope, 'env, F, W>(
+        scope: &'scope Scope<'scope, 'env>,
+        len: usize,
+        threads: usize,
+        budget: usize,
+        weight: W,
+        f: F,
+    ) -> Self
+    where
+        F: Fn(usize) -> R + Send + Sync + 'scope,
+        W: Fn(&R) -> usize + Send + Sync + 'scope,
+        R: 'scope,
+    {
+        Self::spawn(scope, len, threads, usize::MAX, budget, f, weight)
+    }
+
+    fn spawn<'scope, 'env, F, W>(
+        scope: &'scope Scope<'scope, 'env>,
+        len: usize,
+        threads: usize,
+        window: usize,
+        budget: usize,
+        f: F,
+        weight: W,
+    ) -> Self
+    where
+        F: Fn(usize) -> R + Send + Sync + 'scope,
+        W: Fn(&R) -> usize + Send + Sync + 'scope,
+        R: 'scope,
+    {
+        let shared = Arc::new(Shared {
+            state: Mutex::new(State {
+                claimed: 0,
+                consumed: 0,
+                pending: VecDeque::new(),
+                weight: 0,
+                stopped: false,
+            }),
+            ready: Condvar::new(),
+            space: Condvar::new(),
+            window: window.max(1),
+            budget,
+        });
+
+        let worker = Arc::new((f, weight));
+        for _ in 0..threads.max(1).min(len) {
+            let shared = Arc::clone(&shared);
+            let worker = Arc::clone(&worker);
+            scope.spawn(move || {
+                let (f, weight) = &*worker;
+                while let Some(index) = shared.claim(len) {
+                    let result = panic::catch_unwind(AssertUnwindSafe(|| f(index)));
+                    let weight = result.as_ref().map_or(0, weight);
+                    shared.finish(index, result, weight);
+                }
+            });
+        }
+
+        Self {
+            shared,
+            next: 0,
+            len,
+        }
+    }
+}
+
+impl<R> Iterator for ParallelIter<R> {
+    type Item = R;
+
+    fn next(&mut self) -> Option<R> {
+        if self.next >= self.len {
+            return None;
+        }
+
+        let mut state = self.shared.lock();
+        let (result, weight) = loop {
+            if let Some(Some(_)) = state.pending.front() {
+                break state.pending.pop_front().flatten().unwrap();
+            }
+            state = wait(&self.shared.ready, state);
+        };
+        state.consumed += 1;
+        state.weight -= weight;
+        drop(state);
+
+        self.shared.space.notify_all();
+        self.next += 1;
+
+        match result {
+            Ok(result) => Some(result),
+            Err(panic) => panic::resume_unwind(panic),
+        }
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let len = self.len - self.next;
+        (len, Some(len))
+    }
+}
+
+impl<R> ExactSizeIterator for ParallelIter<R> {}
+
+impl<R> Drop for ParallelIter<R> {
+    fn drop(&mut self) {
+        self.shared.lock().stopped = true;
+        self.shared.space.notify_all();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::time::Duration;
+
+    use super::*;
+
+    #[test]
+    fn test_order() {
+        let items: Vec<u64> = (0..1000).collect();
+        for threads in [0, 1, 2, 8, 2000] {
+            let doubled = parallel_map(&items, threads, |x| x * 2);
+            assert!(doubled.iter().copied().eq(items.iter().map(|x| x * 2)));
+        }
+    }
+
+    #[test]
+    fn test_empty() {
+        let items: &[u32] = &[];
+        assert!(parallel_map(items, 4, |x| *x).is_empty());
+    }
+
+    #[test]
+    #[should_panic(expected = "item 3")]
+    fn test_panic() {
+        parallel_map(&[1, 2, 3, 4], 2, |&x| {
+            assert_ne!(x, 3, "item {x}");
+        });
+    }
+
+    #[test]
+    fn test_slow_item() {
+        // The first item is slow, so all other items finish while the iterator waits for it.
+        let claimed = AtomicUsize::new(0);
+        std::thread::scope(|scope| {
+            let iter = ParallelIter::new(scope, 100, 2, |i| {
+                claimed.fetch_add(1, Ordering::Relaxed);
+                if i == 0 {
+                    std::thread::sleep(Duration::from_millis(50));
+                }
+                i
+            });
+            assert!(iter.eq(0..100));
+        });
+        assert_eq!(claimed.into_inner(), 100);
+    }
+
+    #[test]
+    fn test_window() {
+        // Workers may not get more than the window ahead of the iterator.
+        let claimed = AtomicUsize::new(0);
+        std::thread::scope(|scope| {
+            let mut iter = ParallelIter::new(scope, 1000, 2, |i| {
+                claimed.fetch_add(1, Ordering::Relaxed);
+                i
+            });
+            assert_eq!(iter.next(), Some(0));
+            std::thread::sleep(Duration::from_millis(50));
+            assert!(claimed.load(Ordering::Relaxed) <= 1 + 2 * CHUNKS_PER_THREAD);
+            drop(iter);
+        });
+        assert!(claimed.into_inner() < 1000);
+    }
+
+    #[test]
+    fn test_budget() {
+        let claimed = AtomicUsize::new(0);
+        std::thread::scope(|scope| {
+            let mut iter = ParallelIter::with_budget(
+                scope,
+                1000,
+                2,
+                100,
+                |&weight| weight,
+                |_| {
+                    claimed.fetch_add(1, Ordering::Relaxed);
+                    30
+                },
+            );
+            assert_eq!(iter.next(), Some(30));
+            std::thread::sleep(Duration::from_millis(50));
+            // At most four results fit into the budget, plus one being finished by each thread.
+            assert!(claimed.load(Ordering::Relaxed) <= 1 + 4 + 2);
+            assert_eq!(iter.count(), 999);
+        });
+    }
+
+    #[test]
+    #[should_panic(expected = "item 5")]
+    fn test_iter_panic() {
+        std::thread::scope(|scope| {
+            ParallelIter::new(scope, 10, 3, |i| assert_ne!(i, 5, "item {i}")).for_each(drop);
+        });
+    }
+}
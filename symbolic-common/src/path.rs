@@ -184,6 +184,10 @@ pub fn clean_path(path: &str) -> Cow<'_, str> {
     //  - Parent-directory directives may leave an absolute path
     //  - A path is converted to relative when the parent directory hits top-level
 
+    if is_clean_path(path) {
+        return Cow::Borrowed(path);
+    }
+
     let mut rv = String::with_capacity(path.len());
     let main_separator = if is_windows_path(path) { '\\' } else { '/' };
 
@@ -219,11 +223,27 @@ pub fn clean_path(path: &str) -> Cow<'_, str> {
         rv.push_str(segment);
     }
 
-    // For now, always return an owned string.
-    // This can be optimized later.
     Cow::Owned(rv)
 }
 
+/// Returns `true` if [`clean_path`] would return the path unchanged.
+///
+/// This is the case if the path has no `.` or `..` segments, no trailing separator, and only uses
+/// the main separator of its path style. The check is conservative and may reject some paths that
+/// are already clean.
+fn is_clean_path(path: &str) -> bool {
+    let main_separator = if is_windows_path(path) { '\\' } else { '/' };
+
+    !path.ends_with(is_path_separator::<char>)
+        && path
+            .split(is_path_separator::<char>)
+            .all(|segment| segment != "." && segment != "..")
+        && path
+            .chars()
+            .filter(|&c| is_path_separator(c))
+            .all(|c| c == main_separator)
+}
+
 /// Splits off the last component of a path given as bytes.
 ///
 /// The path should be a path to a file, and not a directory with a trailing directory separator. If
@@ -592,6 +612,11 @@ mod tests {
         assert_eq!(clean_path("foo\\bar\\baz/../../../blah/"), "blah");
         assert_eq!(clean_path("foo/bar/baz/../../../blah/"), "blah");
         assert_eq!(clean_path("\\\\foo\\..\\bar"), "\\\\bar");
+
+        assert!(matches!(clean_path("/foo/bar"), Cow::Borrowed(_)));
+        assert!(matches!(clean_path("C:\\foo\\bar"), Cow::Borrowed(_)));
+        assert!(matches!(clean_path("<stdin>"), Cow::Borrowed(_)));
+        assert!(matches!(clean_path("C:\\foo/bar"), Cow::Owned(_)));
         assert_eq!(
             clean_path("foo/bar/../아이쿱 조합원 앱카드"),
             "foo/아이쿱 조합원 앱카드"
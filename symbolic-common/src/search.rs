@@ -0,0 +1,66 @@
+//! Helpers to search sorted slices.
+
+/// Returns the index of the first element of `slice` at or after `start` for which `pred` is
+/// `false`.
+///
+/// Like [`slice::partition_point`], this assumes that `pred` is `true` for a prefix of `slice` and
+/// `false` for the rest, and additionally that `pred` holds for every element before `start`. The
+/// search gallops forward from `start` in exponentially growing steps and then binary searches the
+/// last step, so the cost is logarithmic in the distance from `start` rather than in the length of
+/// `slice`. This makes it the right choice to resolve a sorted batch of keys with a single forward
+/// sweep, passing the previous result as `start`.
+///
+/// # Panics
+///
+/// Panics if `start` is greater than the length of `slice`.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::gallop;
+///
+/// let starts = [0, 10, 20, 30, 40, 50];
+/// let idx = gallop(&starts, 0, |&start| start <= 25);
+/// assert_eq!(idx, 3);
+///
+/// let idx = gallop(&starts, idx, |&start| start <= 45);
+/// assert_eq!(idx, 5);
+/// ```
+pub fn gallop<T, P>(slice: &[T], start: usize, mut pred: P) -> usize
+where
+    P: FnMut(&T) -> bool,
+{
+    let rest = &slice[start..];
+
+    let mut bound = 1;
+    while bound < rest.len() && pred(&rest[bound - 1]) {
+        bound *= 2;
+    }
+
+    let low = bound / 2;
+    let high = bound.min(rest.len());
+    start + low + rest[low..high].partition_point(pred)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_gallop() {
+        let items: Vec<u32> = (0..100).map(|x| x * 2).collect();
+        for start in 0..=items.len() {
+            for key in 0..210 {
+                let expected = items.partition_point(|&x| x <= key).max(start);
+                let found = gallop(&items, start, |&x| x <= key);
+                assert_eq!(found, expected, "{start} {key}");
+            }
+        }
+    }
+
+    #[test]
+    fn test_gallop_empty() {
+        let items: &[u32] = &[];
+        assert_eq!(gallop(items, 0, |_| true), 0);
+    }
+}
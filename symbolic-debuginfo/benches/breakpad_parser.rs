@@ -1,8 +1,8 @@
 use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
 
 use symbolic_common::ByteView;
-use symbolic_debuginfo::breakpad::{BreakpadObject, BreakpadStackRecord};
-use symbolic_testutils::fixture;
+use symbolic_debuginfo::breakpad::{BreakpadObject, BreakpadStackRecord, BreakpadStackRecords};
+use symbolic_testutils::{fixture, large_breakpad_file};
 
 pub fn breakpad_parser(c: &mut Criterion) {
     let mut group = c.benchmark_group("Breakpad parser benchmarks");
@@ -81,5 +81,53 @@ pub fn breakpad_parser(c: &mut Criterion) {
     group.finish();
 }
 
-criterion_group!(benches, breakpad_parser);
+pub fn breakpad_parser_threads(c: &mut Criterion) {
+    let mut group = c.benchmark_group("Breakpad parser thread scaling");
+
+    let data = large_breakpad_file("windows/crash.sym", 50);
+    let object = BreakpadObject::parse(&data).unwrap();
+    let session = object.debug_session().unwrap();
+
+    for threads in [1, 2, 4, 8] {
+        group.bench_with_input(
+            BenchmarkId::new("functions", threads),
+            &threads,
+            |b, &threads| {
+                b.iter(|| {
+                    std::thread::scope(|scope| {
+                        for function in session.functions_parallel(scope, threads) {
+                            function.unwrap();
+                        }
+                    })
+                })
+            },
+        );
+
+        group.bench_with_input(
+            BenchmarkId::new("stack records", threads),
+            &threads,
+            |b, &threads| {
+                let chunks: Vec<_> = object.stack_record_chunks(64 * 1024).collect();
+                b.iter(|| {
+                    std::thread::scope(|scope| {
+                        let per_thread = chunks.len().div_ceil(threads);
+                        for thread_chunks in chunks.chunks(per_thread.max(1)) {
+                            scope.spawn(move || {
+                                for &chunk in thread_chunks {
+                                    for record in BreakpadStackRecords::new(chunk) {
+                                        record.unwrap();
+                                    }
+                                }
+                            });
+                        }
+                    })
+                })
+            },
+        );
+    }
+
+    group.finish();
+}
+
+criterion_group!(benches, breakpad_parser, breakpad_parser_threads);
 criterion_main!(benches);
@@ -0,0 +1,133 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use symbolic_common::{Arch, ByteView};
+use symbolic_debuginfo::macho::{CompactUnwindInfoIter, MachObject};
+use symbolic_testutils::{fixture, Rng};
+
+/// The number of second-level pages in the generated section.
+const PAGES: u32 = 500;
+/// The number of entries in every generated page, close to the maximum of a 4KiB page.
+const ENTRIES_PER_PAGE: u32 = 1000;
+/// The number of addresses looked up per iteration, about one stack trace.
+const FRAMES: usize = 64;
+
+/// Generates an `__unwind_info` section of compressed pages, about the size of a large system
+/// dylib's. Every entry covers 16 bytes of code and uses one of four global opcodes.
+fn large_unwind_info() -> Vec<u8> {
+    const PAGE_SIZE: u32 = 4096;
+    const HEADER_LEN: u32 = 4 * 7;
+    const GLOBAL_OPCODES: [u32; 4] = [0x0101_0000, 0x0102_0000, 0x0202_0000, 0x0400_0000];
+
+    let global_opcodes_offset = HEADER_LEN;
+    let pages_offset = global_opcodes_offset + GLOBAL_OPCODES.len() as u32 * 4;
+    let second_level_offset = (pages_offset + (PAGES + 1) * 12).div_ceil(PAGE_SIZE) * PAGE_SIZE;
+
+    let mut section = Vec::new();
+    let mut write = |value: u32| section.extend_from_slice(&value.to_le_bytes());
+
+    write(1);
+    write(global_opcodes_offset);
+    write(GLOBAL_OPCODES.len() as u32);
+    write(pages_offset);
+    write(0);
+    write(pages_offset);
+    write(PAGES + 1);
+
+    for opcode in GLOBAL_OPCODES {
+        write(opcode);
+    }
+
+    let page_address = |page: u32| 0x1000 + page * ENTRIES_PER_PAGE * 16;
+    for page in 0..PAGES {
+        write(page_address(page));
+        write(second_level_offset + page * PAGE_SIZE);
+        write(0);
+    }
+    write(page_address(PAGES));
+    write(0);
+    write(0);
+
+    section.resize(second_level_offset as usize, 0);
+    for page in 0..PAGES {
+        let start = section.len();
+        section.extend_from_slice(&3u32.to_le_bytes());
+        for value in [12u16, ENTRIES_PER_PAGE as u16, 12, 0] {
+            section.extend_from_slice(&value.to_le_bytes());
+        }
+        for entry in 0..ENTRIES_PER_PAGE {
+            let opcode_idx = (page + entry) % GLOBAL_OPCODES.len() as u32;
+            section.extend_from_slice(&((opcode_idx << 24) | (entry * 16)).to_le_bytes());
+        }
+        section.resize(start + PAGE_SIZE as usize, 0);
+    }
+
+    section
+}
+
+/// Returns `FRAMES` addresses between the first entry and the end of the section.
+fn frame_addresses(iter: &CompactUnwindInfoIter<'_>) -> Vec<u32> {
+    let mut iter = iter.clone();
+    let first = iter.next().unwrap().unwrap().instruction_address;
+    let mut end = first;
+    while let Some(entry) = iter.next().unwrap() {
+        end = entry.instruction_address + entry.len;
+    }
+
+    let mut rng = Rng::new();
+    (0..FRAMES)
+        .map(|_| first + (rng.next_u64() % (end - first) as u64) as u32)
+        .collect()
+}
+
+fn bench_iter(c: &mut Criterion, name: &str, iter: &CompactUnwindInfoIter<'_>) {
+    let mut group = c.benchmark_group("compact unwind");
+    group.throughput(Throughput::Elements(FRAMES as u64));
+    group.sample_size(20);
+
+    let addresses = frame_addresses(iter);
+
+    group.bench_with_input(
+        BenchmarkId::new("entry_for_address", name),
+        &addresses,
+        |b, addresses| {
+            b.iter(|| {
+                for &address in addresses {
+                    criterion::black_box(iter.entry_for_address(address).unwrap());
+                }
+            })
+        },
+    );
+
+    // Without an indexed lookup, all entries have to be read before unwinding the first frame.
+    group.bench_with_input(
+        BenchmarkId::new("full iteration", name),
+        &addresses,
+        |b, addresses| {
+            b.iter(|| {
+                let mut iter = iter.clone();
+                let mut found = 0;
+                while let Some(entry) = iter.next().unwrap() {
+                    let range = entry.instruction_address..entry.instruction_address + entry.len;
+                    found += addresses.iter().filter(|a| range.contains(a)).count();
+                }
+                criterion::black_box(found)
+            })
+        },
+    );
+
+    group.finish();
+}
+
+pub fn compact_unwind_lookup(c: &mut Criterion) {
+    let view = ByteView::open(fixture("macos/crash")).unwrap();
+    let object = MachObject::parse(&view).unwrap();
+    let iter = object.compact_unwind_info().unwrap().unwrap();
+    bench_iter(c, "macos/crash", &iter);
+
+    let section = large_unwind_info();
+    let iter = CompactUnwindInfoIter::new(&section, true, Arch::Amd64).unwrap();
+    bench_iter(c, "generated", &iter);
+}
+
+criterion_group!(benches, compact_unwind_lookup);
+criterion_main!(benches);
@@ -0,0 +1,133 @@
+use std::io::Cursor;
+use std::path::Path;
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+
+use symbolic_debuginfo::sourcebundle::{
+    SourceBundle, SourceBundleDebugSession, SourceBundleWriter, SourceFileInfo,
+};
+
+const FILES: usize = 64;
+const FRAMES: usize = 2048;
+
+/// Generates about 32KiB of source code.
+fn file_contents(file: usize) -> String {
+    (0..1000)
+        .map(|line| format!("int function_{file}_{line}(void);\n"))
+        .collect()
+}
+
+/// Creates a source bundle with `FILES` generated source files of about 32KiB each.
+fn source_bundle() -> Vec<u8> {
+    let mut writer = Cursor::new(Vec::new());
+    let mut bundle = SourceBundleWriter::start(&mut writer).unwrap();
+
+    for i in 0..FILES {
+        let mut info = SourceFileInfo::default();
+        info.set_path(format!("/src/module{i}/file.c"));
+
+        let contents = file_contents(i);
+        bundle
+            .add_file(format!("module{i}/file.c"), contents.as_bytes(), info)
+            .unwrap();
+    }
+
+    bundle.finish().unwrap();
+    writer.into_inner()
+}
+
+/// Returns the paths of `FRAMES` stack frames, which repeatedly point into a few hot files.
+fn frame_paths() -> Vec<String> {
+    (0..FRAMES)
+        .map(|frame| {
+            let module = (frame * 7 + frame / 13) % (FILES / 4);
+            format!("/src/module{module}/file.c")
+        })
+        .collect()
+}
+
+/// Fetches the source of all frames, split across `threads` threads.
+fn fetch_sources(session: &SourceBundleDebugSession<'_>, frames: &[String], threads: usize) {
+    std::thread::scope(|s| {
+        for chunk in frames.chunks(frames.len().div_ceil(threads)) {
+            s.spawn(move || {
+                for path in chunk {
+                    let contents = session.source_contents_by_path(path).unwrap();
+                    criterion::black_box(contents.unwrap());
+                }
+            });
+        }
+    });
+}
+
+pub fn source_bundle_lookup(c: &mut Criterion) {
+    let mut group = c.benchmark_group("SourceBundle lookup");
+    group.sample_size(20);
+
+    let data = source_bundle();
+    let bundle = SourceBundle::parse(&data).unwrap();
+    let frames = frame_paths();
+
+    for cache_size in [0, 4 << 20] {
+        let mut session = bundle.debug_session().unwrap();
+        session.set_cache_size(cache_size);
+
+        for threads in [1, 2, 4, 8] {
+            let name = if cache_size > 0 { "cached" } else { "uncached" };
+            group.bench_with_input(BenchmarkId::new(name, threads), &threads, |b, &threads| {
+                b.iter(|| fetch_sources(&session, &frames, threads))
+            });
+        }
+    }
+
+    group.finish();
+}
+
+/// Writes `FILES` generated source files of about 32KiB each into `dir`, and returns a source
+/// bundle object referencing them by their absolute paths.
+fn object_referencing_files(dir: &Path) -> Vec<u8> {
+    let mut writer = Cursor::new(Vec::new());
+    let mut bundle = SourceBundleWriter::start(&mut writer).unwrap();
+
+    for i in 0..FILES {
+        let path = dir.join(format!("file{i}.c"));
+        let contents = file_contents(i);
+        std::fs::write(&path, contents).unwrap();
+
+        let path = path.to_string_lossy();
+        let mut info = SourceFileInfo::default();
+        info.set_path(path.to_string());
+        bundle.add_file(path, &b""[..], info).unwrap();
+    }
+
+    bundle.finish().unwrap();
+    writer.into_inner()
+}
+
+pub fn source_bundle_write(c: &mut Criterion) {
+    let mut group = c.benchmark_group("SourceBundle write");
+    group.sample_size(20);
+
+    let dir = tempfile::tempdir().unwrap();
+    let data = object_referencing_files(dir.path());
+    let object = SourceBundle::parse(&data).unwrap();
+
+    for threads in [1, 2, 4, 8] {
+        group.bench_with_input(
+            BenchmarkId::new("write_object", threads),
+            &threads,
+            |b, &threads| {
+                b.iter(|| {
+                    let mut writer = SourceBundleWriter::start(Cursor::new(Vec::new())).unwrap();
+                    writer.set_threads(threads);
+                    writer.write_object(&object, "bench").unwrap()
+                })
+            },
+        );
+    }
+
+    group.finish();
+}
+
+criterion_group!(benches, source_bundle_lookup, source_bundle_write);
+criterion_main!(benches);
@@ -2,6 +2,7 @@ use std::borrow::Cow;
 use std::fmt;
 use std::ops::{Bound, Deref, RangeBounds};
 use std::str::FromStr;
+use std::thread::Scope;
 
 use symbolic_common::{clean_path, join_path, Arch, CodeId, DebugId, Name};
 
@@ -714,6 +715,39 @@ pub trait DebugSession<'session> {
     /// caches and optimize resources while resolving function and line information.
     fn functions(&'session self) -> Self::FunctionIterator;
 
+    /// Returns an iterator over all functions in this debug file, parsing them on up to `threads`
+    /// threads spawned on `scope`.
+    ///
+    /// The iterator yields exactly the same functions in the same order as
+    /// [`functions`](Self::functions). Debug formats that support it parse multiple compilation
+    /// units concurrently ahead of the consumer. All other formats fall back to
+    /// [`functions`](Self::functions).
+    ///
+    /// The threads keep running for as long as the iterator is alive, so the iterator must be
+    /// consumed or dropped before the end of `scope`:
+    ///
+    /// ```no_run
+    /// # use symbolic_debuginfo::{DebugSession, Function};
+    /// # fn process(_: &Function<'_>) {}
+    /// # fn example<'s>(session: &'s impl DebugSession<'s>) {
+    /// std::thread::scope(|scope| {
+    ///     for function in session.functions_parallel(scope, 8).flatten() {
+    ///         process(&function);
+    ///     }
+    /// });
+    /// # }
+    /// ```
+    fn functions_parallel<'scope, 'env>(
+        &'session self,
+        _scope: &'scope Scope<'scope, 'env>,
+        _threads: usize,
+    ) -> Self::FunctionIterator
+    where
+        'session: 'scope,
+    {
+        self.functions()
+    }
+
     /// Returns an iterator over all source files referenced by this debug file.
     fn files(&'session self) -> Self::FileIterator;
 
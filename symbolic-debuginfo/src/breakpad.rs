@@ -6,10 +6,12 @@ use std::error::Error;
 use std::fmt;
 use std::ops::Range;
 use std::str;
+use std::sync::Arc;
+use std::thread::Scope;
 
 use thiserror::Error;
 
-use symbolic_common::{Arch, AsSelf, CodeId, DebugId, Language, Name, NameMangling};
+use symbolic_common::{Arch, AsSelf, CodeId, DebugId, Language, Name, NameMangling, ParallelIter};
 
 use crate::base::*;
 use crate::function_builder::FunctionBuilder;
@@ -53,7 +55,7 @@ impl<'data> Iterator for LineOffsets<'data> {
             return None;
         }
 
-        match self.data.iter().position(|b| *b == b'\n') {
+        match memchr::memchr(b'\n', self.data) {
             None => {
                 if self.finished {
                     None
@@ -114,6 +116,33 @@ impl<'data> Iterator for Lines<'data> {
 
 impl std::iter::FusedIterator for Lines<'_> {}
 
+/// Returns the offset of the first line in `data` that starts with the record identifier in
+/// `needle`, or the length of `data` if there is no such line.
+///
+/// The needle must be a newline followed by the record identifier, such as `b"\nFUNC "`. Instead of
+/// splitting `data` into lines, this runs a vectorized substring search, which allows record
+/// iterators to skip over entire sections of a file.
+fn find_line(data: &[u8], needle: &[u8]) -> usize {
+    if data.starts_with(&needle[1..]) {
+        return 0;
+    }
+
+    match memchr::memmem::find(data, needle) {
+        Some(index) => index + 1,
+        None => data.len(),
+    }
+}
+
+/// Skips to the first line in `data` starting with `record`, unless a line starting with `stop`
+/// comes before it.
+///
+/// Both arguments are needles as described in [`find_line`].
+fn skip_to_record<'d>(data: &'d [u8], record: &[u8], stop: &[u8]) -> &'d [u8] {
+    let start = find_line(data, record);
+    let start = find_line(&data[..start], stop);
+    &data[start..]
+}
+
 /// Length at which the breakpad header will be capped.
 ///
 /// This is a protection against reading an entire breakpad file at once if the first characters do
@@ -893,7 +922,7 @@ impl<'d> BreakpadStackRecords<'d> {
     /// Creates an iterator over [`BreakpadStackRecord`]s contained in a slice of data.
     pub fn new(data: &'d [u8]) -> Self {
         Self {
-            lines: Lines::new(data),
+            lines: Lines::new(&data[find_line(data, b"\nSTACK ")..]),
             finished: false,
         }
     }
@@ -925,6 +954,35 @@ impl<'d> Iterator for BreakpadStackRecords<'d> {
     }
 }
 
+/// An iterator over chunks of stack frame records in a Breakpad object.
+///
+/// Returned by [`BreakpadObject::stack_record_chunks`].
+#[derive(Clone, Debug)]
+pub struct BreakpadStackRecordChunks<'d> {
+    data: &'d [u8],
+    chunk_size: usize,
+}
+
+impl<'d> Iterator for BreakpadStackRecordChunks<'d> {
+    type Item = &'d [u8];
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.data.is_empty() {
+            return None;
+        }
+
+        let (chunk, rest) = split_chunk(
+            self.data,
+            self.chunk_size,
+            &[b"\nSTACK CFI INIT", b"\nSTACK WIN"],
+        );
+        self.data = rest;
+        Some(chunk)
+    }
+}
+
+impl std::iter::FusedIterator for BreakpadStackRecordChunks<'_> {}
+
 /// A Breakpad object file.
 ///
 /// To process minidump crash reports without having to understand all sorts of native symbol
@@ -1114,7 +1172,7 @@ impl<'data> BreakpadObject<'data> {
     /// Returns an iterator over public symbol records.
     pub fn public_records(&self) -> BreakpadPublicRecords<'data> {
         BreakpadPublicRecords {
-            lines: Lines::new(self.data),
+            lines: Lines::new(skip_to_record(self.data, b"\nPUBLIC ", b"\nSTACK ")),
             finished: false,
         }
     }
@@ -1122,16 +1180,25 @@ impl<'data> BreakpadObject<'data> {
     /// Returns an iterator over function records.
     pub fn func_records(&self) -> BreakpadFuncRecords<'data> {
         BreakpadFuncRecords {
-            lines: Lines::new(self.data),
+            lines: Lines::new(skip_to_record(self.data, b"\nFUNC ", b"\nSTACK ")),
             finished: false,
         }
     }
 
     /// Returns an iterator over stack frame records.
     pub fn stack_records(&self) -> BreakpadStackRecords<'data> {
-        BreakpadStackRecords {
-            lines: Lines::new(self.data),
-            finished: false,
+        BreakpadStackRecords::new(self.data)
+    }
+
+    /// Returns an iterator over chunks of stack frame records of roughly `chunk_size` bytes.
+    ///
+    /// Chunks are split before `STACK CFI INIT` and `STACK WIN` records, so each chunk can be parsed
+    /// independently with [`BreakpadStackRecords::new`], for instance on multiple threads. Parsing
+    /// all chunks in order yields the same records as [`stack_records`](Self::stack_records).
+    pub fn stack_record_chunks(&self, chunk_size: usize) -> BreakpadStackRecordChunks<'data> {
+        BreakpadStackRecordChunks {
+            data: &self.data[find_line(self.data, b"\nSTACK ")..],
+            chunk_size,
         }
     }
 
@@ -1269,6 +1336,21 @@ impl BreakpadDebugSession<'_> {
         BreakpadFunctionIterator::new(&self.file_map, self.lines.clone())
     }
 
+    /// Returns an iterator over all functions in this debug file, parsing them on up to `threads`
+    /// threads spawned on `scope`.
+    ///
+    /// See [DebugSession::functions_parallel] for more information.
+    pub fn functions_parallel<'s, 'scope, 'env>(
+        &'s self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> BreakpadFunctionIterator<'s>
+    where
+        's: 'scope,
+    {
+        BreakpadFunctionIterator::with_threads(&self.file_map, self.lines.clone(), scope, threads)
+    }
+
     /// Returns an iterator over all source files in this debug file.
     pub fn files(&self) -> BreakpadFileIterator<'_> {
         BreakpadFileIterator {
@@ -1294,6 +1376,17 @@ impl<'session> DebugSession<'session> for BreakpadDebugSession<'_> {
         self.functions()
     }
 
+    fn functions_parallel<'scope, 'env>(
+        &'session self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> Self::FunctionIterator
+    where
+        'session: 'scope,
+    {
+        self.functions_parallel(scope, threads)
+    }
+
     fn files(&'session self) -> Self::FileIterator {
         self.files()
     }
@@ -1320,12 +1413,61 @@ impl<'s> Iterator for BreakpadFileIterator<'s> {
     }
 }
 
+/// The approximate size of the chunks that are parsed on separate threads.
+const PARALLEL_CHUNK_SIZE: usize = 64 * 1024;
+
+/// Splits off a chunk of roughly `chunk_size` bytes from the start of `data`.
+///
+/// The chunk ends right before a line starting with one of the given record identifiers, which
+/// are needles as described in [`find_line`].
+fn split_chunk<'d>(data: &'d [u8], chunk_size: usize, records: &[&[u8]]) -> (&'d [u8], &'d [u8]) {
+    if data.len() <= chunk_size {
+        return (data, &[]);
+    }
+
+    // Start the search at the newline that might precede a record at `chunk_size`.
+    let search = &data[chunk_size.max(1) - 1..];
+    let split = records
+        .iter()
+        .filter_map(|record| memchr::memmem::find(search, record))
+        .min()
+        .map_or(data.len(), |index| chunk_size.max(1) + index);
+
+    data.split_at(split)
+}
+
+/// The state of a [`BreakpadFunctionIterator`] that parses chunks of functions in parallel.
+struct ParallelFunctions<'s> {
+    /// The functions of each chunk, parsed on worker threads. Each chunk ends after its first
+    /// error. Cleared after an error to stop the workers.
+    chunks: Option<ParallelIter<Vec<Result<Function<'s>, BreakpadError>>>>,
+    /// The remaining functions of the current chunk.
+    functions: std::vec::IntoIter<Result<Function<'s>, BreakpadError>>,
+}
+
+impl<'s> ParallelFunctions<'s> {
+    fn next(&mut self) -> Option<Result<Function<'s>, BreakpadError>> {
+        loop {
+            if let Some(function) = self.functions.next() {
+                if function.is_err() {
+                    // The sequential iterator stops at the first error.
+                    self.chunks = None;
+                }
+                return Some(function);
+            }
+
+            self.functions = self.chunks.as_mut()?.next()?.into_iter();
+        }
+    }
+}
+
 /// An iterator over functions in a Breakpad object.
 pub struct BreakpadFunctionIterator<'s> {
     file_map: &'s BreakpadFileMap<'s>,
     next_line: Option<&'s [u8]>,
-    inline_origin_map: BreakpadInlineOriginMap<'s>,
+    inline_origin_map: Arc<BreakpadInlineOriginMap<'s>>,
     lines: Lines<'s>,
+    parallel: Option<ParallelFunctions<'s>>,
 }
 
 impl<'s> BreakpadFunctionIterator<'s> {
@@ -1336,7 +1478,79 @@ impl<'s> BreakpadFunctionIterator<'s> {
             next_line,
             inline_origin_map: Default::default(),
             lines,
+            parallel: None,
+        }
+    }
+
+    /// Creates an iterator that parses chunks of functions on up to `threads` threads spawned on
+    /// `scope`.
+    ///
+    /// Parallel parsing requires all `INLINE_ORIGIN` records to come before the first `FUNC`
+    /// record, which is the case for files written by current versions of Breakpad. Otherwise, this
+    /// falls back to sequential parsing.
+    fn with_threads<'scope, 'env>(
+        file_map: &'s BreakpadFileMap<'s>,
+        lines: Lines<'s>,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> Self
+    where
+        's: 'scope,
+    {
+        let mut iter = Self::new(file_map, lines.clone());
+        if threads <= 1 {
+            return iter;
+        }
+
+        // Functions end at the first stack record, see `next`.
+        let data = lines.0.data;
+        let data = &data[..find_line(data, b"\nSTACK ")];
+        let first_func = find_line(data, b"\nFUNC ");
+        let (header, mut functions) = data.split_at(first_func);
+        if functions.is_empty() || memchr::memmem::find(functions, b"\nINLINE_ORIGIN ").is_some() {
+            return iter;
+        }
+
+        let mut inline_origin_map = BreakpadInlineOriginMap::new();
+        for line in Lines::new(header) {
+            if line.starts_with(b"INLINE_ORIGIN ") {
+                match BreakpadInlineOriginRecord::parse(line) {
+                    Ok(record) => inline_origin_map.insert(record.id, record.name),
+                    // Leave it to the sequential iterator to report the error.
+                    Err(_) => return iter,
+                };
+            }
+        }
+
+        let mut chunks = Vec::new();
+        while !functions.is_empty() {
+            let (chunk, rest) = split_chunk(functions, PARALLEL_CHUNK_SIZE, &[b"\nFUNC "]);
+            chunks.push(chunk);
+            functions = rest;
         }
+
+        let inline_origin_map = Arc::new(inline_origin_map);
+        iter.inline_origin_map = Arc::clone(&inline_origin_map);
+        let parsed = ParallelIter::new(scope, chunks.len(), threads, move |index| {
+            let mut iter = Self::new(file_map, Lines::new(chunks[index]));
+            iter.inline_origin_map = Arc::clone(&inline_origin_map);
+
+            let mut functions = Vec::new();
+            for function in iter {
+                let is_err = function.is_err();
+                functions.push(function);
+                if is_err {
+                    break;
+                }
+            }
+            functions
+        });
+
+        iter.parallel = Some(ParallelFunctions {
+            chunks: Some(parsed),
+            functions: Vec::new().into_iter(),
+        });
+        iter
     }
 }
 
@@ -1344,6 +1558,10 @@ impl<'s> Iterator for BreakpadFunctionIterator<'s> {
     type Item = Result<Function<'s>, BreakpadError>;
 
     fn next(&mut self) -> Option<Self::Item> {
+        if let Some(parallel) = self.parallel.as_mut() {
+            return parallel.next();
+        }
+
         // Advance to the next FUNC line.
         let line = loop {
             let line = self.next_line.take()?;
@@ -1362,7 +1580,7 @@ impl<'s> Iterator for BreakpadFunctionIterator<'s> {
                     Ok(record) => record,
                     Err(e) => return Some(Err(e)),
                 };
-                self.inline_origin_map
+                Arc::make_mut(&mut self.inline_origin_map)
                     .insert(inline_origin_record.id, inline_origin_record.name);
             }
 
@@ -1396,7 +1614,7 @@ impl<'s> Iterator for BreakpadFunctionIterator<'s> {
                     Ok(record) => record,
                     Err(e) => return Some(Err(e)),
                 };
-                self.inline_origin_map
+                Arc::make_mut(&mut self.inline_origin_map)
                     .insert(inline_origin_record.id, inline_origin_record.name);
                 continue;
             }
@@ -2523,6 +2741,26 @@ mod tests {
 
     use similar_asserts::assert_eq;
 
+    #[test]
+    fn test_find_line() {
+        assert_eq!(find_line(b"FUNC 0 1 0 a\n", b"\nFUNC "), 0);
+        assert_eq!(find_line(b"MODULE x\nFUNC 0 1 0 a\n", b"\nFUNC "), 9);
+        assert_eq!(find_line(b"MODULE x\r\nFUNC 0 1 0 a\n", b"\nFUNC "), 10);
+        assert_eq!(find_line(b"MODULE x\nINFO FUNC 0\n", b"\nFUNC "), 21);
+        assert_eq!(find_line(b"", b"\nFUNC "), 0);
+    }
+
+    #[test]
+    fn test_skip_to_record() {
+        let data = b"MODULE x\nFUNC 0 1 0 a\n0 1 1 0\nSTACK CFI INIT 0 1 .cfa: $rsp 8 +\n";
+        assert!(skip_to_record(data, b"\nFUNC ", b"\nSTACK ").starts_with(b"FUNC "));
+        assert!(skip_to_record(data, b"\nPUBLIC ", b"\nSTACK ").starts_with(b"STACK "));
+
+        // Records after the stop record are not found.
+        let data = b"MODULE x\nSTACK WIN 4 0 1 0 0 0 0 0 0 1 x\nFUNC 0 1 0 a\n";
+        assert!(skip_to_record(data, b"\nFUNC ", b"\nSTACK ").starts_with(b"STACK "));
+    }
+
     #[test]
     fn test_lineoffsets_fused() {
         let data = b"";
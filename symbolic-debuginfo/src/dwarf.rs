@@ -16,6 +16,7 @@ use std::fmt;
 use std::marker::PhantomData;
 use std::ops::Deref;
 use std::sync::Arc;
+use std::thread::Scope;
 
 use fallible_iterator::FallibleIterator;
 use gimli::read::{AttributeValue, Error as GimliError, Range};
@@ -23,7 +24,7 @@ use gimli::{constants, AbbreviationsCacheStrategy, DwarfFileType, UnitSectionOff
 use once_cell::sync::OnceCell;
 use thiserror::Error;
 
-use symbolic_common::{AsSelf, Language, Name, NameMangling, SelfCell};
+use symbolic_common::{AsSelf, Language, Name, NameMangling, ParallelIter, SelfCell};
 
 use crate::base::*;
 use crate::function_builder::FunctionBuilder;
@@ -1237,6 +1238,52 @@ impl<'d> DwarfInfo<'d> {
             index: 0,
         }
     }
+
+    /// Returns an iterator over all functions.
+    fn functions(&'d self, bcsymbolmap: Option<&'d BcSymbolMap<'d>>) -> DwarfFunctionIterator<'d> {
+        DwarfFunctionIterator {
+            units: self.units(bcsymbolmap),
+            functions: Vec::new().into_iter(),
+            seen_ranges: BTreeSet::new(),
+            finished: false,
+            parsed: None,
+        }
+    }
+
+    /// Returns an iterator over all functions, parsing compilation units on up to `threads`
+    /// threads spawned on `scope`.
+    fn functions_parallel<'scope, 'env>(
+        &'d self,
+        bcsymbolmap: Option<&'d BcSymbolMap<'d>>,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> DwarfFunctionIterator<'d>
+    where
+        'd: 'scope,
+    {
+        let mut iter = self.functions(bcsymbolmap);
+        if threads <= 1 {
+            return iter;
+        }
+
+        // Each unit is parsed with its own set of seen ranges, so that units do not depend on each
+        // other. `next_parsed_unit` later reconciles them with the ranges of all previous units.
+        iter.parsed = Some(ParallelIter::new(
+            scope,
+            self.headers.len(),
+            threads,
+            move |index| {
+                let mut seen_ranges = BTreeSet::new();
+                let result = parse_unit_functions(self, bcsymbolmap, index, &mut seen_ranges);
+                ParsedUnit {
+                    index,
+                    result,
+                    seen_ranges,
+                }
+            },
+        ));
+        iter
+    }
 }
 
 impl<'slf, 'd: 'slf> AsSelf<'slf> for DwarfInfo<'d> {
@@ -1339,12 +1386,24 @@ impl<'data> DwarfDebugSession<'data> {
 
     /// Returns an iterator over all functions in this debug file.
     pub fn functions(&self) -> DwarfFunctionIterator<'_> {
-        DwarfFunctionIterator {
-            units: self.cell.get().units(self.bcsymbolmap.as_deref()),
-            functions: Vec::new().into_iter(),
-            seen_ranges: BTreeSet::new(),
-            finished: false,
-        }
+        self.cell.get().functions(self.bcsymbolmap.as_deref())
+    }
+
+    /// Returns an iterator over all functions in this debug file, parsing compilation units on up
+    /// to `threads` threads spawned on `scope`.
+    ///
+    /// See [DebugSession::functions_parallel] for more information.
+    pub fn functions_parallel<'s, 'scope, 'env>(
+        &'s self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> DwarfFunctionIterator<'s>
+    where
+        's: 'scope,
+    {
+        self.cell
+            .get()
+            .functions_parallel(self.bcsymbolmap.as_deref(), scope, threads)
     }
 
     /// See [DebugSession::source_by_path] for more information.
@@ -1365,6 +1424,17 @@ impl<'session> DebugSession<'session> for DwarfDebugSession<'_> {
         self.functions()
     }
 
+    fn functions_parallel<'scope, 'env>(
+        &'session self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> Self::FunctionIterator
+    where
+        'session: 'scope,
+    {
+        self.functions_parallel(scope, threads)
+    }
+
     fn files(&'session self) -> Self::FileIterator {
         self.files()
     }
@@ -1448,12 +1518,64 @@ impl<'s> Iterator for DwarfFileIterator<'s> {
     }
 }
 
+/// The functions of a single compilation unit, parsed ahead of time on a worker thread.
+struct ParsedUnit<'s> {
+    /// The index of the compilation unit.
+    index: usize,
+    /// The parsed functions, or `None` if the unit was skipped.
+    result: Result<Option<Vec<Function<'s>>>, DwarfError>,
+    /// The ranges encountered while parsing this unit.
+    seen_ranges: BTreeSet<(u64, u64)>,
+}
+
+/// Parses all functions of the compilation unit at the given index.
+fn parse_unit_functions<'s>(
+    info: &'s DwarfInfo<'s>,
+    bcsymbolmap: Option<&'s BcSymbolMap<'s>>,
+    index: usize,
+    seen_ranges: &mut BTreeSet<(u64, u64)>,
+) -> Result<Option<Vec<Function<'s>>>, DwarfError> {
+    let unit = match info.get_unit(index)? {
+        Some(unit) => unit,
+        None => return Ok(None),
+    };
+
+    match DwarfUnit::from_unit(unit, info, bcsymbolmap)? {
+        Some(unit) => unit.functions(seen_ranges).map(Some),
+        None => Ok(None),
+    }
+}
+
 /// An iterator over functions in a DWARF file.
 pub struct DwarfFunctionIterator<'s> {
     units: DwarfUnitIterator<'s>,
     functions: std::vec::IntoIter<Function<'s>>,
     seen_ranges: BTreeSet<(u64, u64)>,
     finished: bool,
+    /// Compilation units that are parsed ahead on worker threads, in unit order.
+    parsed: Option<ParallelIter<ParsedUnit<'s>>>,
+}
+
+impl<'s> DwarfFunctionIterator<'s> {
+    /// Returns the functions of the next compilation unit parsed ahead of time.
+    ///
+    /// A unit parsed on its own yields the same functions as in a sequential parse, unless it
+    /// encountered a range that a previous unit has already seen. Such units are parsed again
+    /// against the ranges of all previous units.
+    fn next_parsed_unit(&mut self) -> Option<Result<Option<Vec<Function<'s>>>, DwarfError>> {
+        let unit = self.parsed.as_mut()?.next()?;
+        if unit.seen_ranges.is_disjoint(&self.seen_ranges) {
+            self.seen_ranges.extend(unit.seen_ranges);
+            return Some(unit.result);
+        }
+
+        Some(parse_unit_functions(
+            self.units.info,
+            self.units.bcsymbolmap,
+            unit.index,
+            &mut self.seen_ranges,
+        ))
+    }
 }
 
 impl<'s> Iterator for DwarfFunctionIterator<'s> {
@@ -1469,6 +1591,15 @@ impl<'s> Iterator for DwarfFunctionIterator<'s> {
                 return Some(Ok(func));
             }
 
+            if self.parsed.is_some() {
+                self.functions = match self.next_parsed_unit() {
+                    Some(Ok(functions)) => functions.unwrap_or_default().into_iter(),
+                    Some(Err(error)) => return Some(Err(error)),
+                    None => break,
+                };
+                continue;
+            }
+
             let unit = match self.units.next() {
                 Some(Ok(unit)) => unit,
                 Some(Err(error)) => return Some(Err(error)),
@@ -1506,4 +1637,39 @@ mod tests {
         let sections = DwarfSections::from_dwarf(&obj);
         assert_eq!(sections.debug_str_offsets.data.len(), 48);
     }
+
+    #[cfg(feature = "elf")]
+    #[test]
+    fn test_functions_parallel_overlapping_units() {
+        use crate::elf::ElfObject;
+
+        fn functions<'d>(info: &'d DwarfInfo<'d>, threads: usize) -> String {
+            std::thread::scope(|scope| {
+                let functions = info.functions_parallel(None, scope, threads);
+                format!("{:?}", functions.collect::<Result<Vec<_>, _>>().unwrap())
+            })
+        }
+
+        let data = std::fs::read(symbolic_testutils::fixture("linux/crash.debug")).unwrap();
+        let obj = ElfObject::parse(&data).unwrap();
+        let sections = DwarfSections::from_dwarf(&obj);
+        let info = DwarfInfo::parse(&sections, SymbolMap::new(), 0, obj.kind()).unwrap();
+
+        // List every compilation unit twice, as if the linker had merged identical code from
+        // several units. Every second unit then only contains ranges that were seen before, so
+        // parallel workers always collide with the previous unit and have to parse it again.
+        let mut duplicated = DwarfInfo::parse(&sections, SymbolMap::new(), 0, obj.kind()).unwrap();
+        duplicated.headers = info.headers.iter().flat_map(|&h| [h, h]).collect();
+        duplicated.units = duplicated.headers.iter().map(|_| OnceCell::new()).collect();
+
+        let expected = functions(&info, 1);
+        assert_eq!(functions(&duplicated, 1), expected);
+        for threads in [2, 3, 8] {
+            assert_eq!(
+                functions(&duplicated, threads),
+                expected,
+                "{threads} threads"
+            );
+        }
+    }
 }
@@ -6,7 +6,7 @@
 //!
 //! The [`CompactUnwindInfoIter]` lets you iterate through all of the mappings
 //! from instruction addresses to unwinding instructions, or lookup a specific
-//! mapping by instruction address (unimplemented).
+//! mapping by instruction address.
 //!
 //!
 //!
@@ -73,16 +73,15 @@
 //! }
 //! ```
 //!
-//! If you want to unwind from a specific location, do something like this
-//! (API not yet implemented!):
+//! If you want to unwind from a specific location, do something like this:
 //!
-//! ```rust,ignore
+//! ```
 //! use symbolic_debuginfo::macho::{
 //!     CompactCfiOp, CompactCfiRegister, CompactUnwindOp,
 //!     CompactUnwindInfoIter, MachError, MachObject,
 //! };
 //!
-//! fn unwind_one_frame<'d>(mut iter: CompactUnwindInfoIter<'d>, current_address_in_module: u32)
+//! fn unwind_one_frame<'d>(iter: CompactUnwindInfoIter<'d>, current_address_in_module: u32)
 //!     -> Result<(), MachError>
 //! {
 //!     if let Some(entry) = iter.entry_for_address(current_address_in_module)? {
@@ -138,7 +137,6 @@
 //! # Unimplemented Features (TODO)
 //!
 //! * Personality/LSDA lookup (for runtime unwinders)
-//! * Entry lookup by address (for runtime unwinders)
 //! * x86/x64 Stackless-Indirect mode decoding (for stack frames > 2KB)
 //!
 //!
@@ -1135,13 +1133,104 @@ impl<'a> CompactUnwindInfoIter<'a> {
         Ok(Some(entry))
     }
 
-    /*
     /// Gets the entry associated with a particular address.
-    pub fn entry_for_address(&mut self, _address: u32) -> Result<Option<CompactUnwindInfoEntry>> {
-        // TODO: this would be nice for an actual unwinding implementation, but
-        // dumping all of the entries doesn't need this.
+    ///
+    /// This binary searches the first-level page index for the second-level page that maps
+    /// `address`, and then binary searches the entries of that page. It does not allocate and does
+    /// not change the state of the iterator. The returned entry is the same one that iteration
+    /// would yield for this address, including its `len`, even if it extends into the next page.
+    ///
+    /// Returns `None` if the address is not mapped by this section.
+    pub fn entry_for_address(&self, address: u32) -> Result<Option<CompactUnwindInfoEntry>> {
+        // Find the last page with `first_address <= address`. The last first-level entry is the
+        // sentinel, so addresses mapped by the section always land before it.
+        let mut low = 0;
+        let mut high = self.root.pages_len;
+        while low < high {
+            let mid = low + (high - low) / 2;
+            match self.first_level_entry(mid)? {
+                Some(entry) if entry.first_address <= address => low = mid + 1,
+                _ => high = mid,
+            }
+        }
+
+        let Some(mut page_idx) = low.checked_sub(1) else {
+            return Ok(None);
+        };
+
+        let mut first_level_entry = self.first_level_entry(page_idx)?.unwrap();
+        if first_level_entry.second_level_page_offset == 0 {
+            // At or past the sentinel
+            return Ok(None);
+        }
+        let mut second_level_page =
+            self.second_level_page(first_level_entry.second_level_page_offset)?;
+
+        // Find the last entry with `instruction_address <= address` in this page.
+        let mut low = 0;
+        let mut high = second_level_page.len();
+        while low < high {
+            let mid = low + (high - low) / 2;
+            let entry = self.second_level_entry(&first_level_entry, &second_level_page, mid)?;
+            if entry.instruction_address <= address {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        let second_idx = match low.checked_sub(1) {
+            Some(second_idx) => second_idx,
+            None => {
+                // The address precedes the first entry of its page, so it is covered by the last
+                // entry of the previous page.
+                let Some(prev_page_idx) = page_idx.checked_sub(1) else {
+                    return Ok(None);
+                };
+                page_idx = prev_page_idx;
+                first_level_entry = self.first_level_entry(page_idx)?.unwrap();
+                second_level_page =
+                    self.second_level_page(first_level_entry.second_level_page_offset)?;
+                match second_level_page.len().checked_sub(1) {
+                    Some(second_idx) => second_idx,
+                    None => return Ok(None),
+                }
+            }
+        };
+
+        let entry = self.second_level_entry(&first_level_entry, &second_level_page, second_idx)?;
+
+        // The entry covers everything up to the next entry, which may be the first entry of the
+        // next page or the sentinel.
+        let next_address = if second_idx + 1 < second_level_page.len() {
+            self.second_level_entry(&first_level_entry, &second_level_page, second_idx + 1)?
+                .instruction_address
+        } else {
+            match self.first_level_entry(page_idx + 1)? {
+                Some(next_entry) if next_entry.second_level_page_offset == 0 => {
+                    next_entry.first_address
+                }
+                Some(next_entry) => {
+                    let next_page = self.second_level_page(next_entry.second_level_page_offset)?;
+                    if next_page.len() == 0 {
+                        next_entry.first_address
+                    } else {
+                        self.second_level_entry(&next_entry, &next_page, 0)?
+                            .instruction_address
+                    }
+                }
+                None => return Ok(None),
+            }
+        };
+
+        if address >= next_address {
+            return Ok(None);
+        }
+
+        let entry =
+            self.complete_entry(&entry, next_address, &first_level_entry, &second_level_page)?;
+        Ok(Some(entry))
     }
-    */
 
     fn first_level_entry(&self, idx: u32) -> Result<Option<FirstLevelPageEntry>> {
         if idx < self.root.pages_len {
@@ -2216,6 +2305,7 @@ mod test {
         let mut iter = CompactUnwindInfoIter::new(&section, true, Arch::Amd64)?;
         assert!(iter.next()?.is_none());
         assert!(iter.next()?.is_none());
+        assert!(iter.entry_for_address(0)?.is_none());
 
         Ok(())
     }
@@ -2463,6 +2553,24 @@ mod test {
         assert!(iter.next()?.is_none());
         assert_eq!(orig_entries.next(), None);
 
+        // Make sure lookups agree with iteration, including entries that run to the next page
+        let mut iter = CompactUnwindInfoIter::new(&section, true, Arch::Amd64)?;
+        while let Some(entry) = iter.next()? {
+            let first = entry.instruction_address;
+            let last = first + entry.len - 1;
+            for address in [first, first + entry.len / 2, last] {
+                let found = iter.entry_for_address(address)?.unwrap();
+                assert_eq!(found.instruction_address, entry.instruction_address);
+                assert_eq!(found.len, entry.len);
+                assert_eq!(found.opcode.0, entry.opcode.0);
+            }
+        }
+
+        // Addresses before the first entry and at or after the sentinel are not mapped
+        assert!(iter.entry_for_address(0)?.is_none());
+        assert!(iter.entry_for_address(cur_address + 1)?.is_none());
+        assert!(iter.entry_for_address(u32::MAX)?.is_none());
+
         Ok(())
     }
 
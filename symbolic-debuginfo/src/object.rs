@@ -2,6 +2,7 @@
 
 use std::error::Error;
 use std::fmt;
+use std::thread::Scope;
 
 use symbolic_common::{Arch, AsSelf, CodeId, DebugId};
 use symbolic_ppdb::PortablePdb;
@@ -471,6 +472,29 @@ impl ObjectDebugSession<'_> {
         }
     }
 
+    /// Returns an iterator over all functions in this debug file, parsing them on up to `threads`
+    /// threads spawned on `scope`.
+    ///
+    /// See [DebugSession::functions_parallel] for more information.
+    pub fn functions_parallel<'s, 'scope, 'env>(
+        &'s self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> ObjectFunctionIterator<'s>
+    where
+        's: 'scope,
+    {
+        match *self {
+            ObjectDebugSession::Breakpad(ref s) => {
+                ObjectFunctionIterator::Breakpad(s.functions_parallel(scope, threads))
+            }
+            ObjectDebugSession::Dwarf(ref s) => {
+                ObjectFunctionIterator::Dwarf(s.functions_parallel(scope, threads))
+            }
+            _ => self.functions(),
+        }
+    }
+
     /// Returns an iterator over all source files referenced by this debug file.
     pub fn files(&self) -> ObjectFileIterator<'_> {
         match *self {
@@ -517,6 +541,17 @@ impl<'session> DebugSession<'session> for ObjectDebugSession<'_> {
         self.functions()
     }
 
+    fn functions_parallel<'scope, 'env>(
+        &'session self,
+        scope: &'scope Scope<'scope, 'env>,
+        threads: usize,
+    ) -> Self::FunctionIterator
+    where
+        'session: 'scope,
+    {
+        self.functions_parallel(scope, threads)
+    }
+
     fn files(&'session self) -> Self::FileIterator {
         self.files()
     }
@@ -52,15 +52,17 @@ use std::fs::{File, OpenOptions};
 use std::io::{BufReader, BufWriter, ErrorKind, Read, Seek, Write};
 use std::path::Path;
 use std::sync::Arc;
+use std::thread::Scope;
 use std::{fmt, io};
 
-use parking_lot::Mutex;
 use regex::Regex;
 use serde::{Deserialize, Deserializer, Serialize};
 use thiserror::Error;
 use zip::{write::SimpleFileOptions, ZipWriter};
 
-use symbolic_common::{Arch, AsSelf, CodeId, DebugId, SourceLinkMappings};
+use symbolic_common::{
+    Arch, AsSelf, CodeId, DebugId, ParallelIter, ShardedCache, SourceLinkMappings,
+};
 
 use self::utf8_reader::Utf8Reader;
 use crate::base::*;
@@ -80,6 +82,9 @@ static MANIFEST_PATH: &str = "manifest.json";
 /// Path at which files will be written into the bundle.
 static FILES_PATH: &str = "files";
 
+/// The maximum size of compressed files that are buffered when writing bundles on multiple threads.
+const PARALLEL_BUFFER_SIZE: usize = 32 * 1024 * 1024;
+
 lazy_static::lazy_static! {
     static ref SANE_PATH_RE: Regex = Regex::new(r":?[/\\]+").unwrap();
 }
@@ -340,11 +345,18 @@ impl SourceFileInfo {
 ///
 /// Debug sessions are not permitted to return invalid source file descriptors.
 pub struct SourceFileDescriptor<'a> {
-    contents: Option<Cow<'a, str>>,
+    contents: Option<DescriptorContents<'a>>,
     remote_url: Option<Cow<'a, str>>,
     file_info: Option<&'a SourceFileInfo>,
 }
 
+/// The contents of a [`SourceFileDescriptor`].
+enum DescriptorContents<'a> {
+    Cow(Cow<'a, str>),
+    /// Contents shared with the source cache of a [`SourceBundleDebugSession`].
+    Shared(Arc<str>),
+}
+
 impl<'a> SourceFileDescriptor<'a> {
     /// Creates an embedded source file descriptor.
     pub(crate) fn new_embedded(
@@ -352,7 +364,19 @@ impl<'a> SourceFileDescriptor<'a> {
         file_info: Option<&'a SourceFileInfo>,
     ) -> SourceFileDescriptor<'a> {
         SourceFileDescriptor {
-            contents: Some(content),
+            contents: Some(DescriptorContents::Cow(content)),
+            remote_url: None,
+            file_info,
+        }
+    }
+
+    /// Creates an embedded source file descriptor that shares its contents with a cache.
+    fn new_shared(
+        content: Arc<str>,
+        file_info: Option<&'a SourceFileInfo>,
+    ) -> SourceFileDescriptor<'a> {
+        SourceFileDescriptor {
+            contents: Some(DescriptorContents::Shared(content)),
             remote_url: None,
             file_info,
         }
@@ -381,15 +405,23 @@ impl<'a> SourceFileDescriptor<'a> {
     /// a file descriptor is created, but the contents are missing and instead the
     /// [`url`](Self::url) can be used.
     pub fn contents(&self) -> Option<&str> {
-        self.contents.as_deref()
+        match self.contents.as_ref()? {
+            DescriptorContents::Cow(contents) => Some(contents),
+            DescriptorContents::Shared(contents) => Some(contents),
+        }
     }
 
     /// The contents of the source file as string, if it's available.
     ///
     /// This unwraps the [`SourceFileDescriptor`] directly and might avoid a copy of `contents`
-    /// later on.
+    /// later on. Contents that are shared with the source cache of a
+    /// [`SourceBundleDebugSession`] are copied, since the cache keeps its own reference. Use
+    /// [`contents`](Self::contents) to borrow them instead.
     pub fn into_contents(self) -> Option<Cow<'a, str>> {
-        self.contents
+        match self.contents? {
+            DescriptorContents::Cow(contents) => Some(contents),
+            DescriptorContents::Shared(contents) => Some(Cow::Owned(contents.to_string())),
+        }
     }
 
     /// If available returns the URL of this source.
@@ -532,9 +564,18 @@ struct SourceBundleManifest {
     pub attributes: BTreeMap<String, String>,
 }
 
+/// The location of a file in the zip archive of a bundle.
+#[derive(Clone, Debug)]
+struct ZipEntry {
+    /// The path of the file in the archive, which is also its key in the manifest.
+    path: Arc<String>,
+    /// The index of the file in the central directory, or `None` if the archive is missing it.
+    index: Option<usize>,
+}
+
 struct SourceBundleIndex<'data> {
     manifest: SourceBundleManifest,
-    indexed_files: HashMap<FileKey<'data>, Arc<String>>,
+    indexed_files: HashMap<FileKey<'data>, ZipEntry>,
 }
 
 impl<'data> SourceBundleIndex<'data> {
@@ -551,18 +592,22 @@ impl<'data> SourceBundleIndex<'data> {
         let mut indexed_files = HashMap::with_capacity(files.len());
 
         for (zip_path, file_info) in files {
-            let zip_path = Arc::new(zip_path.clone());
+            // Resolve the central directory entry once, so that lookups can read files by index.
+            let entry = ZipEntry {
+                index: archive.index_for_name(zip_path),
+                path: Arc::new(zip_path.clone()),
+            };
             if !file_info.path.is_empty() {
                 indexed_files.insert(
                     FileKey::Path(normalize_path(&file_info.path).into()),
-                    zip_path.clone(),
+                    entry.clone(),
                 );
             }
             if !file_info.url.is_empty() {
-                indexed_files.insert(FileKey::Url(file_info.url.clone().into()), zip_path.clone());
+                indexed_files.insert(FileKey::Url(file_info.url.clone().into()), entry.clone());
             }
             if let (Some(debug_id), Some(ty)) = (file_info.debug_id(), file_info.ty()) {
-                indexed_files.insert(FileKey::DebugId(debug_id, ty), zip_path.clone());
+                indexed_files.insert(FileKey::DebugId(debug_id, ty), entry.clone());
             }
         }
 
@@ -739,11 +784,6 @@ impl<'data> SourceBundle<'data> {
     /// efficient access to various records in the debug information. Since this can be quite a
     /// costly process, try to reuse the debugging session as long as possible.
     pub fn debug_session(&self) -> Result<SourceBundleDebugSession<'data>, SourceBundleError> {
-        // NOTE: The `SourceBundleDebugSession` still needs interior mutability, so it still needs
-        // to carry its own Mutex. However that is still preferable to sharing the Mutex of the
-        // `SourceBundle`, which might be shared by multiple threads.
-        // The only thing here that really needs to be `mut` is the `Cursor` / `Seek` position.
-        let archive = Mutex::new(self.archive.clone());
         let source_links = SourceLinkMappings::new(
             self.index
                 .manifest
@@ -753,8 +793,9 @@ impl<'data> SourceBundle<'data> {
         );
         Ok(SourceBundleDebugSession {
             index: Arc::clone(&self.index),
-            archive,
+            archive: self.archive.clone(),
             source_links,
+            cache: None,
         })
     }
 
@@ -877,10 +918,15 @@ enum FileKey<'a> {
 }
 
 /// Debug session for SourceBundle objects.
+///
+/// Sources can be retrieved from multiple threads concurrently. Every lookup decompresses the file
+/// independently, unless a cache is enabled with [`set_cache_size`](Self::set_cache_size).
 pub struct SourceBundleDebugSession<'data> {
-    archive: Mutex<zip::read::ZipArchive<std::io::Cursor<&'data [u8]>>>,
+    archive: zip::read::ZipArchive<std::io::Cursor<&'data [u8]>>,
     index: Arc<SourceBundleIndex<'data>>,
     source_links: SourceLinkMappings,
+    /// Decompressed files by their index in the archive.
+    cache: Option<ShardedCache<usize, Arc<str>>>,
 }
 
 impl SourceBundleDebugSession<'_> {
@@ -896,17 +942,99 @@ impl SourceBundleDebugSession<'_> {
         std::iter::empty()
     }
 
-    /// Get source by the path of a file in the bundle.
-    fn source_by_zip_path(&self, zip_path: &str) -> Result<String, SourceBundleError> {
-        let mut archive = self.archive.lock();
+    /// Enables a cache of decompressed files, holding approximately `max_bytes` of file contents.
+    ///
+    /// Without a cache, every lookup decompresses the file again. With a cache, repeated lookups of
+    /// the same file share its contents until it is evicted in favor of more recently used files.
+    /// Files that would take up a large part of `max_bytes` are never cached. Passing `0` disables
+    /// the cache.
+    pub fn set_cache_size(&mut self, max_bytes: usize) {
+        self.cache = (max_bytes > 0).then(|| ShardedCache::new(max_bytes));
+    }
+
+    /// Opens a file in the bundle and passes a reader of its decompressed contents and its
+    /// decompressed size to `f`.
+    fn with_zip_entry<T, F>(&self, entry: &ZipEntry, f: F) -> Result<T, SourceBundleError>
+    where
+        F: FnOnce(&mut dyn Read, u64) -> io::Result<T>,
+    {
+        let index = entry.index.ok_or_else(|| {
+            SourceBundleError::new(
+                SourceBundleErrorKind::BadZip,
+                zip::result::ZipError::FileNotFound,
+            )
+        })?;
+
+        // Clones of the archive share the parsed central directory and only differ in their read
+        // position, so every lookup gets its own cheaply without locking.
+        let mut archive = self.archive.clone();
         let mut file = archive
-            .by_name(zip_path)
+            .by_index(index)
             .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::BadZip, e))?;
-        let mut source_content = String::new();
+        let size = file.size();
 
-        file.read_to_string(&mut source_content)
-            .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::BadZip, e))?;
-        Ok(source_content)
+        f(&mut file, size).map_err(|e| SourceBundleError::new(SourceBundleErrorKind::BadZip, e))
+    }
+
+    /// Decompresses a file in the bundle.
+    fn read_zip_entry(&self, entry: &ZipEntry) -> Result<String, SourceBundleError> {
+        self.with_zip_entry(entry, |file, size| {
+            let mut source_content = String::with_capacity(size.try_into().unwrap_or(0));
+            file.read_to_string(&mut source_content)?;
+            Ok(source_content)
+        })
+    }
+
+    /// Decompresses a file in the bundle directly into shared contents.
+    ///
+    /// The contents are allocated once with the size from the zip header and filled in place,
+    /// instead of being copied from a `String`.
+    fn read_shared_zip_entry(&self, entry: &ZipEntry) -> Result<Arc<str>, SourceBundleError> {
+        self.with_zip_entry(entry, |file, size| {
+            let size =
+                usize::try_from(size).map_err(|e| io::Error::new(ErrorKind::InvalidData, e))?;
+
+            // Collecting from an iterator of known length allocates the `Arc` exactly once.
+            let mut contents: Arc<[u8]> = std::iter::repeat(0).take(size).collect();
+            let buffer = Arc::get_mut(&mut contents).expect("contents are not shared yet");
+            file.read_exact(buffer)?;
+
+            // Reading to the end validates the checksum of the file.
+            if file.read(&mut [0])? != 0 {
+                let message = "file is larger than its zip header states";
+                return Err(io::Error::new(ErrorKind::InvalidData, message));
+            }
+
+            std::str::from_utf8(&contents)
+                .map_err(|e| io::Error::new(ErrorKind::InvalidData, e))?;
+
+            // SAFETY: The contents were validated as UTF-8 above, and `str` has the same layout
+            // as `[u8]`.
+            Ok(unsafe { Arc::from_raw(Arc::into_raw(contents) as *const str) })
+        })
+    }
+
+    /// Returns the shared contents of a file in the bundle, using the cache if it is enabled.
+    fn shared_zip_entry(&self, entry: &ZipEntry) -> Result<Arc<str>, SourceBundleError> {
+        let (Some(cache), Some(index)) = (&self.cache, entry.index) else {
+            return self.read_shared_zip_entry(entry);
+        };
+
+        if let Some(contents) = cache.get(&index) {
+            return Ok(contents);
+        }
+
+        let contents = self.read_shared_zip_entry(entry)?;
+        cache.insert(index, Arc::clone(&contents), contents.len());
+        Ok(contents)
+    }
+
+    /// Looks up the shared contents of an embedded file.
+    fn get_source_contents(&self, key: FileKey) -> Result<Option<Arc<str>>, SourceBundleError> {
+        match self.index.indexed_files.get(&key) {
+            Some(entry) => self.shared_zip_entry(entry).map(Some),
+            None => Ok(None),
+        }
     }
 
     /// Looks up a source file descriptor.
@@ -917,11 +1045,16 @@ impl SourceBundleDebugSession<'_> {
         &self,
         key: FileKey,
     ) -> Result<Option<SourceFileDescriptor<'_>>, SourceBundleError> {
-        if let Some(zip_path) = self.index.indexed_files.get(&key) {
-            let zip_path = zip_path.as_str();
-            let content = Cow::Owned(self.source_by_zip_path(zip_path)?);
-            let info = self.index.manifest.files.get(zip_path);
-            let descriptor = SourceFileDescriptor::new_embedded(content, info);
+        if let Some(entry) = self.index.indexed_files.get(&key) {
+            // With a cache, the descriptor shares the cached contents instead of copying them.
+            let info = self.index.manifest.files.get(entry.path.as_str());
+            let descriptor = match self.cache {
+                Some(_) => SourceFileDescriptor::new_shared(self.shared_zip_entry(entry)?, info),
+                None => {
+                    let content = Cow::Owned(self.read_zip_entry(entry)?);
+                    SourceFileDescriptor::new_embedded(content, info)
+                }
+            };
             return Ok(Some(descriptor));
         }
 
@@ -971,6 +1104,33 @@ impl SourceBundleDebugSession<'_> {
     ) -> Result<Option<SourceFileDescriptor<'_>>, SourceBundleError> {
         self.get_source_file_descriptor(FileKey::DebugId(debug_id, ty))
     }
+
+    /// Returns the contents of an embedded file by its path.
+    ///
+    /// Unlike [`source_by_path`](Self::source_by_path), this does not resolve source links and
+    /// returns contents that can be shared between threads. If the cache is enabled, repeated
+    /// lookups of the same file return the same allocation.
+    pub fn source_contents_by_path(
+        &self,
+        path: &str,
+    ) -> Result<Option<Arc<str>>, SourceBundleError> {
+        self.get_source_contents(FileKey::Path(normalize_path(path).into()))
+    }
+
+    /// Like [`source_contents_by_path`](Self::source_contents_by_path) but looks up by URL.
+    pub fn source_contents_by_url(&self, url: &str) -> Result<Option<Arc<str>>, SourceBundleError> {
+        self.get_source_contents(FileKey::Url(url.into()))
+    }
+
+    /// Like [`source_contents_by_path`](Self::source_contents_by_path) but looks up by debug ID
+    /// and file type, see [`source_by_debug_id`](Self::source_by_debug_id).
+    pub fn source_contents_by_debug_id(
+        &self,
+        debug_id: DebugId,
+        ty: SourceFileType,
+    ) -> Result<Option<Arc<str>>, SourceBundleError> {
+        self.get_source_contents(FileKey::DebugId(debug_id, ty))
+    }
 }
 
 impl<'session> DebugSession<'session> for SourceBundleDebugSession<'_> {
@@ -1108,6 +1268,7 @@ where
     manifest: SourceBundleManifest,
     writer: ZipWriter<W>,
     collect_il2cpp: bool,
+    threads: usize,
     skipped_file_callback: Box<dyn FnMut(SkippedFileInfo)>,
 }
 
@@ -1136,6 +1297,7 @@ where
             manifest: SourceBundleManifest::new(),
             writer: ZipWriter::new(writer),
             collect_il2cpp: false,
+            threads: 0,
             skipped_file_callback: Box::new(|_| ()),
         })
     }
@@ -1151,6 +1313,17 @@ where
         self.collect_il2cpp = collect_il2cpp;
     }
 
+    /// Sets the number of threads used to read and compress source files in
+    /// [`write_object`](Self::write_object).
+    ///
+    /// By default, and with values of `0` or `1`, files are read and compressed on the current
+    /// thread. Otherwise, workers stop reading ahead while too many compressed files wait to be
+    /// written, which bounds the memory held by them. The files are always written in the same
+    /// order, so the manifest is identical regardless of the number of threads.
+    pub fn set_threads(&mut self, threads: usize) {
+        self.threads = threads;
+    }
+
     /// Sets a meta data attribute of the bundle.
     ///
     /// Attributes are flushed to the bundle when it is [finished]. Thus, they can be retrieved or
@@ -1288,6 +1461,70 @@ where
         result
     }
 
+    /// Adds a file that has been compressed by [`compress_source`] to the bundle.
+    ///
+    /// Errors are handled like in [`add_file_skip_read_failed`](Self::add_file_skip_read_failed).
+    fn add_compressed_file(&mut self, source: CompressedSource) -> Result<(), SourceBundleError> {
+        let data = match source.data {
+            Ok(data) => data,
+            Err(e) if e.kind == SourceBundleErrorKind::ReadFailed => {
+                let reason = e.to_string();
+                let skipped_info = SkippedFileInfo::new(&source.bundle_path, &reason);
+                (self.skipped_file_callback)(skipped_info);
+                return Ok(());
+            }
+            Err(e) => return Err(e),
+        };
+
+        let full_path = self.file_path(&source.bundle_path);
+        let unique_path = self.unique_path(full_path);
+
+        let mut archive = zip::read::ZipArchive::new(std::io::Cursor::new(data))
+            .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::WriteFailed, e))?;
+        let file = archive
+            .by_index_raw(0)
+            .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::WriteFailed, e))?;
+        self.writer
+            .raw_copy_file_rename(file, unique_path.clone())
+            .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::WriteFailed, e))?;
+
+        self.manifest.files.insert(unique_path, source.info);
+        Ok(())
+    }
+
+    /// Reads and compresses the given files on threads spawned on `scope`, and adds them to the
+    /// bundle in order.
+    ///
+    /// Workers stop reading ahead while more than [`PARALLEL_BUFFER_SIZE`] bytes of compressed
+    /// files wait to be written. Files that cannot be read are skipped. If `referenced_files` is
+    /// given, it collects the files referenced by il2cpp source annotations.
+    fn add_files_parallel<'scope, 'env>(
+        &mut self,
+        scope: &'scope Scope<'scope, 'env>,
+        filenames: Vec<String>,
+        mut referenced_files: Option<&mut BTreeSet<String>>,
+    ) -> Result<(), SourceBundleError> {
+        let collect_il2cpp = referenced_files.is_some();
+
+        let sources = ParallelIter::with_budget(
+            scope,
+            filenames.len(),
+            self.threads,
+            PARALLEL_BUFFER_SIZE,
+            |source: &Option<CompressedSource>| source.as_ref().map_or(0, CompressedSource::size),
+            move |index| compress_source(&filenames[index], collect_il2cpp),
+        );
+
+        for mut source in sources.flatten() {
+            if let Some(ref mut referenced_files) = referenced_files {
+                referenced_files.append(&mut source.referenced_files);
+            }
+            self.add_compressed_file(source)?;
+        }
+
+        Ok(())
+    }
+
     /// Set a callback, which is called for every file that is skipped from being included in the
     /// source bundle. The callback receives information about the file being skipped.
     pub fn with_skipped_file_callback(
@@ -1324,6 +1561,8 @@ where
     /// This finishes the source bundle and flushes the underlying writer.
     ///
     /// Before a file is written a callback is invoked which can return `false` to skip a file.
+    ///
+    /// To read and compress files on multiple threads, use [`set_threads`](Self::set_threads).
     pub fn write_object_with_filter<'data, 'object, O, E, F>(
         mut self,
         object: &'object O,
@@ -1337,6 +1576,7 @@ where
     {
         let mut files_handled = BTreeSet::new();
         let mut referenced_files = BTreeSet::new();
+        let mut pending_files = Vec::new();
 
         let session = object
             .debug_session()
@@ -1364,12 +1604,17 @@ where
                 let source_from_object = session
                     .source_by_path(&filename)
                     .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::BadDebugFile, e))?;
-                if filter(&file, &source_from_object) {
+                if !filter(&file, &source_from_object) {
+                    None
+                } else if self.threads > 1 {
+                    // Files are read and compressed on worker threads once all files have been
+                    // visited.
+                    pending_files.push(filename.clone());
+                    None
+                } else {
                     // Note: we could also use source code directly from the object, but that's not
                     // what happened here previously - only collected locally present files.
                     std::fs::read(&filename).ok()
-                } else {
-                    None
                 }
             };
 
@@ -1389,18 +1634,29 @@ where
             files_handled.insert(filename);
         }
 
-        for filename in referenced_files {
-            if files_handled.contains(&filename) {
-                continue;
-            }
+        if self.threads > 1 {
+            std::thread::scope(|scope| {
+                let collect_il2cpp = self.collect_il2cpp.then_some(&mut referenced_files);
+                self.add_files_parallel(scope, pending_files, collect_il2cpp)?;
 
-            if let Some(source) = File::open(&filename).ok().map(BufReader::new) {
-                let bundle_path = sanitize_bundle_path(&filename);
-                let mut info = SourceFileInfo::new();
-                info.set_ty(SourceFileType::Source);
-                info.set_path(filename.clone());
+                referenced_files.retain(|filename| !files_handled.contains(filename));
+                let referenced_files = referenced_files.into_iter().collect();
+                self.add_files_parallel(scope, referenced_files, None)
+            })?;
+        } else {
+            for filename in referenced_files {
+                if files_handled.contains(&filename) {
+                    continue;
+                }
 
-                self.add_file_skip_read_failed(bundle_path, source, info)?
+                if let Some(source) = File::open(&filename).ok().map(BufReader::new) {
+                    let bundle_path = sanitize_bundle_path(&filename);
+                    let mut info = SourceFileInfo::new();
+                    info.set_ty(SourceFileType::Source);
+                    info.set_path(filename.clone());
+
+                    self.add_file_skip_read_failed(bundle_path, source, info)?
+                }
             }
         }
 
@@ -1478,6 +1734,74 @@ fn collect_il2cpp_sources(source: &[u8], referenced_files: &mut BTreeSet<String>
     }
 }
 
+/// A source file that has been read and compressed by [`compress_source`].
+struct CompressedSource {
+    /// The path of the file in the bundle, before deduplication.
+    bundle_path: String,
+    info: SourceFileInfo,
+    /// A zip archive containing only the compressed file, or the error that occurred reading it.
+    data: Result<Vec<u8>, SourceBundleError>,
+    /// Files referenced by il2cpp source annotations in this file.
+    referenced_files: BTreeSet<String>,
+}
+
+impl CompressedSource {
+    /// Returns the approximate number of bytes held by this source.
+    fn size(&self) -> usize {
+        let data = self.data.as_ref().map_or(0, Vec::len);
+        data + self.bundle_path.len()
+    }
+}
+
+/// Reads a source file from disk and compresses it into a standalone zip archive.
+///
+/// Returns `None` if the file cannot be read. The compressed file is later copied into the bundle
+/// by [`SourceBundleWriter::add_compressed_file`] without compressing it again.
+fn compress_source(filename: &str, collect_il2cpp: bool) -> Option<CompressedSource> {
+    let source = std::fs::read(filename).ok()?;
+
+    let mut referenced_files = BTreeSet::new();
+    if collect_il2cpp {
+        collect_il2cpp_sources(&source, &mut referenced_files);
+    }
+
+    let mut info = SourceFileInfo::new();
+    info.set_ty(SourceFileType::Source);
+    info.set_path(filename.to_owned());
+
+    Some(CompressedSource {
+        bundle_path: sanitize_bundle_path(filename),
+        info,
+        data: compress_file(source.as_slice()),
+        referenced_files,
+    })
+}
+
+/// Compresses a file into a zip archive containing only that file.
+///
+/// Like [`SourceBundleWriter::add_file`], only files containing valid UTF-8 are accepted.
+fn compress_file<R: Read>(file: R) -> Result<Vec<u8>, SourceBundleError> {
+    let mut writer = ZipWriter::new(std::io::Cursor::new(Vec::new()));
+    writer
+        .start_file("source", default_file_options())
+        .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::WriteFailed, e))?;
+
+    if let Err(e) = io::copy(&mut Utf8Reader::new(file), &mut writer) {
+        // ErrorKind::InvalidData is returned by Utf8Reader when the file is not valid UTF-8.
+        let error_kind = match e.kind() {
+            ErrorKind::InvalidData => SourceBundleErrorKind::ReadFailed,
+            _ => SourceBundleErrorKind::WriteFailed,
+        };
+
+        return Err(SourceBundleError::new(error_kind, e));
+    }
+
+    let cursor = writer
+        .finish()
+        .map_err(|e| SourceBundleError::new(SourceBundleErrorKind::WriteFailed, e))?;
+    Ok(cursor.into_inner())
+}
+
 impl SourceBundleWriter<BufWriter<File>> {
     /// Create a bundle writer that writes its output to the given path.
     ///
@@ -1556,6 +1880,55 @@ mod tests {
         is_sendsync::<SourceBundleDebugSession>();
     }
 
+    #[test]
+    fn test_concurrent_source_contents() -> Result<(), SourceBundleError> {
+        let mut writer = Cursor::new(Vec::new());
+        let mut bundle = SourceBundleWriter::start(&mut writer)?;
+
+        for i in 0..8 {
+            let mut info = SourceFileInfo::default();
+            info.set_path(format!("/src/file{i}.c"));
+            let contents = format!("// file {i}\n").repeat(100);
+            bundle.add_file(format!("file{i}.c"), contents.as_bytes(), info)?;
+        }
+
+        bundle.finish()?;
+        let bundle_bytes = writer.into_inner();
+        let bundle = SourceBundle::parse(&bundle_bytes)?;
+
+        let mut sess = bundle.debug_session()?;
+        sess.set_cache_size(64 * 1024);
+
+        std::thread::scope(|s| {
+            for _ in 0..4 {
+                s.spawn(|| {
+                    for i in 0..8 {
+                        let path = format!("/src/file{i}.c");
+                        let contents = sess.source_contents_by_path(&path).unwrap().unwrap();
+                        let expected = format!("// file {i}\n").repeat(100);
+                        assert_eq!(&*contents, expected.as_str());
+
+                        let descriptor = sess.source_by_path(&path).unwrap().unwrap();
+                        assert_eq!(descriptor.contents(), Some(&*contents));
+                    }
+                });
+            }
+        });
+
+        // The cache holds the most recently used files and shares their contents.
+        let first = sess.source_contents_by_path("/src/file7.c")?.unwrap();
+        let second = sess.source_contents_by_path("/src/file7.c")?.unwrap();
+        assert!(Arc::ptr_eq(&first, &second));
+
+        // Descriptors borrow the cached contents instead of copying them.
+        let descriptor = sess.source_by_path("/src/file7.c")?.unwrap();
+        assert_eq!(descriptor.contents().unwrap().as_ptr(), first.as_ptr());
+
+        assert!(sess.source_contents_by_path("/src/missing.c")?.is_none());
+
+        Ok(())
+    }
+
     #[test]
     fn test_normalize_paths() -> Result<(), SourceBundleError> {
         let mut writer = Cursor::new(Vec::new());
@@ -1804,6 +2177,78 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_write_object_parallel() -> Result<(), Box<dyn std::error::Error>> {
+        let dir = tempfile::tempdir()?;
+        let cs_path = dir.path().join("referenced.cs");
+        std::fs::write(&cs_path, "some C# source")?;
+
+        // An object referencing more files than fit into a single batch, including a file that is
+        // not valid UTF-8 and a file that does not exist.
+        let object_buf = {
+            let mut writer = Cursor::new(Vec::new());
+            let mut bundle = SourceBundleWriter::start(&mut writer)?;
+
+            let mut paths: Vec<_> = (0..50)
+                .map(|i| dir.path().join(format!("file{i}.cpp")))
+                .collect();
+            paths.push(dir.path().join("missing.cpp"));
+
+            for (i, path) in paths.iter().enumerate() {
+                let contents = match i {
+                    7 => vec![0, 159, 146, 150],
+                    13 => format!("//<source_info:{}:1>\n", cs_path.display()).into_bytes(),
+                    _ => format!("file {i}\n").repeat(i).into_bytes(),
+                };
+                if i < 50 {
+                    std::fs::write(path, &contents)?;
+                }
+
+                let path = path.to_string_lossy();
+                let mut info = SourceFileInfo::new();
+                info.set_ty(SourceFileType::Source);
+                info.set_path(path.to_string());
+                bundle.add_file(path, &b"x"[..], info)?;
+            }
+
+            bundle.finish()?;
+            writer.into_inner()
+        };
+        let object = SourceBundle::parse(&object_buf)?;
+
+        let write_bundle = |threads| -> Result<_, SourceBundleError> {
+            let mut output = Cursor::new(Vec::new());
+            let mut writer = SourceBundleWriter::start(&mut output)?;
+            writer.collect_il2cpp_sources(true);
+            writer.set_threads(threads);
+            assert!(writer.write_object(&object, "whatever")?);
+            Ok(output.into_inner())
+        };
+
+        let serial = write_bundle(1)?;
+        let parallel = write_bundle(2)?;
+
+        let serial = SourceBundle::parse(&serial)?;
+        let parallel = SourceBundle::parse(&parallel)?;
+        assert_eq!(
+            serde_json::to_string(&serial.index.manifest)?,
+            serde_json::to_string(&parallel.index.manifest)?,
+        );
+        assert_eq!(parallel.index.manifest.files.len(), 50);
+
+        let serial = serial.debug_session()?;
+        let parallel = parallel.debug_session()?;
+        for file in parallel.files() {
+            let path = file?.abs_path_str();
+            assert_eq!(
+                serial.source_contents_by_path(&path)?,
+                parallel.source_contents_by_path(&path)?,
+            );
+        }
+
+        Ok(())
+    }
+
     #[test]
     fn test_bundle_paths() {
         assert_eq!(sanitize_bundle_path("foo"), "foo");
@@ -2,9 +2,13 @@ use std::{env, ffi::CString, fmt, io::BufWriter};
 
 use symbolic_common::ByteView;
 use symbolic_debuginfo::{
-    elf::ElfObject, pe::PeObject, FileEntry, Function, LineInfo, Object, SymbolMap,
+    breakpad::{BreakpadObject, BreakpadStackRecord, BreakpadStackRecords},
+    elf::ElfObject,
+    macho::MachObject,
+    pe::PeObject,
+    FileEntry, Function, LineInfo, Object, SymbolMap,
 };
-use symbolic_testutils::fixture;
+use symbolic_testutils::{fixture, large_breakpad_file};
 
 use similar_asserts::assert_eq;
 
@@ -203,6 +207,61 @@ fn test_breakpad_functions_mac_with_inlines() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn test_breakpad_functions_parallel() -> Result<(), Error> {
+    for path in ["windows/crash.sym", "macos/crash.inlines.sym"] {
+        let data = large_breakpad_file(path, 20);
+        let object = Object::parse(&data)?;
+        let session = object.debug_session()?;
+
+        let functions = session.functions().collect::<Result<Vec<_>, _>>()?;
+        for threads in [2, 3, 8] {
+            let parallel = std::thread::scope(|scope| {
+                session
+                    .functions_parallel(scope, threads)
+                    .collect::<Result<Vec<_>, _>>()
+            })?;
+            assert_eq!(format!("{parallel:?}"), format!("{functions:?}"), "{path}");
+        }
+    }
+
+    Ok(())
+}
+
+#[test]
+fn test_breakpad_stack_record_chunks() -> Result<(), Error> {
+    let data = large_breakpad_file("macos/crash.sym", 20);
+    let object = BreakpadObject::parse(&data)?;
+
+    let format_record = |record: BreakpadStackRecord<'_>| match record {
+        BreakpadStackRecord::Cfi(cfi) => {
+            let deltas: Vec<_> = cfi.deltas().map(Result::unwrap).collect();
+            format!(
+                "{:x} {:x} {} {deltas:?}",
+                cfi.start, cfi.size, cfi.init_rules
+            )
+        }
+        BreakpadStackRecord::Win(win) => format!("{win:?}"),
+    };
+
+    let records = object
+        .stack_records()
+        .map(|record| format_record(record.unwrap()))
+        .collect::<Vec<_>>();
+
+    let chunks: Vec<_> = object.stack_record_chunks(4096).collect();
+    assert!(chunks.len() > 1);
+
+    let chunked = chunks
+        .into_iter()
+        .flat_map(BreakpadStackRecords::new)
+        .map(|record| format_record(record.unwrap()))
+        .collect::<Vec<_>>();
+    assert_eq!(chunked, records);
+
+    Ok(())
+}
+
 #[test]
 fn test_elf_executable() -> Result<(), Error> {
     let view = ByteView::open(fixture("linux/crash"))?;
@@ -451,6 +510,32 @@ fn test_mach_symbols() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn test_mach_compact_unwind_lookup() -> Result<(), Error> {
+    let view = ByteView::open(fixture("macos/crash"))?;
+    let object = MachObject::parse(&view)?;
+
+    let mut iter = object.compact_unwind_info()?.unwrap();
+    let lookup = iter.clone();
+    let mut count = 0;
+    while let Some(entry) = iter.next()? {
+        if entry.len == 0 {
+            continue;
+        }
+
+        let last = entry.instruction_address + entry.len - 1;
+        for address in [entry.instruction_address, last] {
+            let found = lookup.entry_for_address(address)?.unwrap();
+            assert_eq!(found.instruction_address, entry.instruction_address);
+            assert_eq!(found.len, entry.len);
+        }
+        count += 1;
+    }
+
+    assert!(count > 0);
+    Ok(())
+}
+
 #[test]
 fn test_mach_files() -> Result<(), Error> {
     let view = ByteView::open(fixture("macos/crash.dSYM/Contents/Resources/DWARF/crash"))?;
@@ -477,6 +562,30 @@ fn test_mach_functions() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn test_functions_parallel() -> Result<(), Error> {
+    for path in [
+        "linux/crash.debug",
+        "macos/crash.dSYM/Contents/Resources/DWARF/crash",
+    ] {
+        let view = ByteView::open(fixture(path))?;
+        let object = Object::parse(&view)?;
+        let session = object.debug_session()?;
+
+        let functions = session.functions().collect::<Result<Vec<_>, _>>()?;
+        for threads in [2, 3, 8] {
+            let parallel = std::thread::scope(|scope| {
+                session
+                    .functions_parallel(scope, threads)
+                    .collect::<Result<Vec<_>, _>>()
+            })?;
+            assert_eq!(format!("{parallel:?}"), format!("{functions:?}"), "{path}");
+        }
+    }
+
+    Ok(())
+}
+
 #[test]
 fn test_pe_32() -> Result<(), Error> {
     let view = ByteView::open(fixture("windows/crash.exe"))?;
@@ -0,0 +1,365 @@
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use regex::Regex;
+
+use symbolic_common::{Language, Name, NameMangling};
+use symbolic_demangle::{
+    demangle_swift_baseline, demangle_swift_renderings, swift_demangler_stats, swift_module_name,
+    Demangle, DemangleOptions, SwiftDemangleCache, SwiftDemanglerStats,
+};
+use symbolic_testutils::Rng;
+
+/// Counts the allocations made through the Rust allocator.
+///
+/// Allocations of the C++ demangler bypass this allocator. Its node slabs are reported through
+/// [`SwiftDemanglerStats`] instead.
+struct CountingAllocator;
+
+static ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+static ALLOCATED_BYTES: AtomicU64 = AtomicU64::new(0);
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        ALLOCATED_BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        ALLOCATED_BYTES.fetch_add(new_size as u64, Ordering::Relaxed);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
+/// A mix of Swift manglings as they show up in iOS crash reports, taken from `tests/test_swift.rs`.
+const SYMBOLS: &[&str] = &[
+    "_T08mangling9r13757744ySaySiG1x_tF",
+    "_T08mangling3ZimC4zangyx_qd__tlF",
+    "_T08mangling28uses_objc_class_and_protocolySo8NSObjectC1o_So8NSAnsing_p1ptF",
+    "_T08mangling10HasVarInitV5stateSbvpZfiSbyKXKfu_",
+    "$S8mangling14uses_optionals1xs7UnicodeO6ScalarVSgSiSg_tF",
+    "$S8mangling4fooByyxAA12HasAssocTypeRzAA0D4Reqt0D0RpzlF",
+    "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF",
+    "$s8mangling24InstanceAndClassPropertyV8propertySivgZ",
+    "$s8mangling14varargsVsArray3arr1nySaySiGd_SStF",
+    "$s7ranking22propertyVersusFunctionyyAA1P_p_xtAaCRzlFyAaC_pcAaC_pcfu_",
+    "$s10Speediness17NetworkQualityCLIO3run10sequentialAC6ResultVSb_tYaKFZTf4nd_nTQ0_",
+    "$ss27withTaskCancellationHandler9operation8onCancel9isolationxxyYaKXE_yyYbXEScA_pSgYitYaKlFTwb",
+    "$s11Supercharge2AXO7ElementPAAE8elements33_35EDDAA799FBB5B74D2F426690B0D99DLL3for2asSayqd__GSo28NSAccessibilityAttributeNamea_qd__mtSo7AXErrorVYKAcDRd__lFAC3AppC_AC6WindowCTgm5",
+];
+
+/// Symbols as found in the symbol table of a typical iOS app binary, most of which are not Swift.
+///
+/// Names without a language go through all language probes in `detect_language`, so the Swift
+/// check runs for every C symbol and every name that cannot be classified.
+const SYMBOL_TABLE: &[&str] = &[
+    "_main",
+    "main",
+    "_objc_msgSend",
+    "__mh_execute_header",
+    "_OBJC_CLASS_$_AppDelegate",
+    "-[AppDelegate application:didFinishLaunchingWithOptions:]",
+    "+[NSObject load]",
+    "_ZN7simdjson8internal9to_charsEPcPKcd",
+    "__ZN5realm5Table10insert_rowEm",
+    "?h@@YAXH@Z",
+    "_ZN3std2rt10lang_start17h0bfe2bb0c7d2e1a9E",
+    "__swift_FORCE_LOAD_$_swiftFoundation",
+    "_swift_retain",
+    "_swift_release",
+    "sqlite3_exec",
+    "pthread_mutex_lock",
+    "_dispatch_once",
+    "$s8mangling6curry1yyF",
+    "_$s8mangling24InstanceAndClassPropertyV8propertySivgZ",
+    "_T08mangling3barSiyKF",
+    "@__swiftmacro_1a13testStringifyAA10stringifyfMf_",
+    "OUTLINED_FUNCTION_12",
+    "_block_invoke.42",
+    "GCC_except_table3",
+];
+
+fn swift_names() -> Vec<Name<'static>> {
+    SYMBOLS
+        .iter()
+        .map(|symbol| Name::new(*symbol, NameMangling::Mangled, Language::Swift))
+        .collect()
+}
+
+/// Demangles the corpus over and over on a single thread.
+///
+/// Compare runs with `--save-baseline` / `--baseline` to see the effect of changes to the
+/// demangler context and allocation strategy in `swiftdemangle.cpp`.
+fn bench_demangle(c: &mut Criterion) {
+    let names = swift_names();
+    let mut group = c.benchmark_group("swift demangle");
+    group.throughput(Throughput::Elements(names.len() as u64));
+
+    for (label, opts) in [
+        ("complete", DemangleOptions::complete()),
+        ("name_only", DemangleOptions::name_only()),
+    ] {
+        group.bench_function(label, |b| {
+            b.iter(|| {
+                for name in &names {
+                    criterion::black_box(name.demangle(opts));
+                }
+            })
+        });
+    }
+
+    group.finish();
+}
+
+/// Demangles the corpus through the old per-call `demangleSymbolAsString` path and through the
+/// per-thread context that `Demangle::demangle` uses.
+///
+/// Before benchmarking, prints the heap allocations per symbol of both variants: allocations of
+/// the Rust allocator, which include the returned names, and the node slabs of the demangler.
+fn bench_baseline(c: &mut Criterion) {
+    let names = swift_names();
+    let opts = DemangleOptions::complete();
+
+    let mut stats = SwiftDemanglerStats::default();
+    let allocations = count_allocations(|| {
+        for name in &names {
+            criterion::black_box(demangle_swift_baseline(name.as_str(), opts, &mut stats));
+        }
+    });
+    print_allocations("baseline", names.len(), allocations, &stats);
+
+    // The first pass sets up the per-thread context and is not counted.
+    for name in &names {
+        criterion::black_box(name.demangle(opts));
+    }
+    let before = swift_demangler_stats();
+    let allocations = count_allocations(|| {
+        for name in &names {
+            criterion::black_box(name.demangle(opts));
+        }
+    });
+    let after = swift_demangler_stats();
+    let stats = SwiftDemanglerStats {
+        slab_count: after.slab_count - before.slab_count,
+        slab_bytes: after.slab_bytes - before.slab_bytes,
+        ..Default::default()
+    };
+    print_allocations("per-thread context", names.len(), allocations, &stats);
+
+    let mut group = c.benchmark_group("swift demangle baseline");
+    group.throughput(Throughput::Elements(names.len() as u64));
+
+    group.bench_function("baseline (demangleSymbolAsString)", |b| {
+        let mut stats = SwiftDemanglerStats::default();
+        b.iter(|| {
+            for name in &names {
+                criterion::black_box(demangle_swift_baseline(name.as_str(), opts, &mut stats));
+            }
+        })
+    });
+
+    group.bench_function("per-thread context", |b| {
+        b.iter(|| {
+            for name in &names {
+                criterion::black_box(name.demangle(opts));
+            }
+        })
+    });
+
+    group.finish();
+}
+
+/// Returns the number and total size of Rust allocations made by `f`.
+fn count_allocations(f: impl FnOnce()) -> (u64, u64) {
+    let allocations = ALLOCATIONS.load(Ordering::Relaxed);
+    let bytes = ALLOCATED_BYTES.load(Ordering::Relaxed);
+    f();
+    (
+        ALLOCATIONS.load(Ordering::Relaxed) - allocations,
+        ALLOCATED_BYTES.load(Ordering::Relaxed) - bytes,
+    )
+}
+
+fn print_allocations(label: &str, symbols: usize, rust: (u64, u64), stats: &SwiftDemanglerStats) {
+    let symbols = symbols as f64;
+    println!(
+        "{label}: {:.1} Rust allocations ({:.0} bytes) and {:.1} demangler slabs ({:.0} bytes) per symbol",
+        rust.0 as f64 / symbols,
+        rust.1 as f64 / symbols,
+        stats.slab_count as f64 / symbols,
+        stats.slab_bytes as f64 / symbols,
+    );
+}
+
+/// Renders every symbol for display and for grouping, once with a separate parse per rendering
+/// and once from a single parse.
+fn bench_renderings(c: &mut Criterion) {
+    let names = swift_names();
+    let options = [DemangleOptions::complete(), DemangleOptions::name_only()];
+    let mut group = c.benchmark_group("swift renderings");
+    group.throughput(Throughput::Elements(names.len() as u64));
+
+    group.bench_function("demangle per rendering", |b| {
+        b.iter(|| {
+            for name in &names {
+                for opts in options {
+                    criterion::black_box(name.demangle(opts));
+                }
+            }
+        })
+    });
+
+    group.bench_function("demangle_swift_renderings", |b| {
+        b.iter(|| {
+            for name in &names {
+                criterion::black_box(demangle_swift_renderings(name.as_str(), &options));
+            }
+        })
+    });
+
+    group.finish();
+}
+
+/// Returns all distinct mangled names from the Swift test suite.
+fn test_corpus() -> Vec<&'static str> {
+    let mut names: Vec<_> = include_str!("../tests/test_swift.rs")
+        .lines()
+        .filter_map(|line| line.trim().strip_prefix('"')?.split_once("\" =>"))
+        .map(|(mangled, _)| mangled)
+        .collect();
+    names.sort_unstable();
+    names.dedup();
+    names
+}
+
+/// Samples `count` indexes into `0..n` following a Zipf distribution with exponent `s`.
+///
+/// This models crash reports of a single app version, where few frames make up the bulk of all
+/// events. Uses a fixed seed so that runs are comparable.
+fn zipf_indexes(n: usize, s: f64, count: usize) -> Vec<usize> {
+    let mut cdf = Vec::with_capacity(n);
+    let mut total = 0.0;
+    for rank in 1..=n {
+        total += 1.0 / (rank as f64).powf(s);
+        cdf.push(total);
+    }
+
+    let mut rng = Rng::new();
+    (0..count)
+        .map(|_| {
+            let sample = (rng.next_u64() >> 11) as f64 / (1u64 << 53) as f64 * total;
+            cdf.partition_point(|&c| c < sample).min(n - 1)
+        })
+        .collect()
+}
+
+/// Replays a Zipf-distributed stream of Swift frames with and without a demangle cache.
+fn bench_cache(c: &mut Criterion) {
+    let corpus = test_corpus();
+    let replay: Vec<_> = zipf_indexes(corpus.len(), 1.1, 10_000)
+        .into_iter()
+        .map(|index| corpus[index])
+        .collect();
+
+    let mut group = c.benchmark_group("swift demangle cache");
+    group.throughput(Throughput::Elements(replay.len() as u64));
+
+    group.bench_function("uncached", |b| {
+        b.iter(|| {
+            for mangled in &replay {
+                let name = Name::new(*mangled, NameMangling::Mangled, Language::Swift);
+                criterion::black_box(name.demangle(DemangleOptions::complete()));
+            }
+        })
+    });
+
+    // The small budget holds only a fraction of the corpus and exercises eviction.
+    for (label, budget) in [("cached 1 MiB", 1024 * 1024), ("cached 16 KiB", 16 * 1024)] {
+        let cache = SwiftDemangleCache::new(budget);
+        group.bench_function(label, |b| {
+            b.iter(|| {
+                for mangled in &replay {
+                    criterion::black_box(cache.demangle(mangled, DemangleOptions::complete()));
+                }
+            })
+        });
+    }
+
+    group.finish();
+}
+
+/// Detects the language of unclassified symbol table entries.
+fn bench_detect_language(c: &mut Criterion) {
+    let names: Vec<_> = SYMBOL_TABLE
+        .iter()
+        .map(|symbol| Name::from(*symbol))
+        .collect();
+    let mut group = c.benchmark_group("swift detection");
+    group.throughput(Throughput::Elements(names.len() as u64));
+
+    group.bench_function("detect_language", |b| {
+        b.iter(|| {
+            for name in &names {
+                criterion::black_box(name.detect_language());
+            }
+        })
+    });
+
+    group.finish();
+}
+
+/// Extracts the module name of Swift symbols.
+///
+/// The baseline demangles the full name and takes the leading identifier, which is what callers had
+/// to do before the demangler exposed the module directly.
+fn bench_module_name(c: &mut Criterion) {
+    let names = swift_names();
+    let module = Regex::new(r"^(?:[^(<]*? )?([A-Za-z_][A-Za-z0-9_]*)\.").unwrap();
+
+    let mut group = c.benchmark_group("swift module name");
+    group.throughput(Throughput::Elements(names.len() as u64));
+
+    group.bench_function("demangle + regex", |b| {
+        b.iter(|| {
+            for name in &names {
+                let demangled = name.demangle(DemangleOptions::complete());
+                let module = demangled
+                    .as_deref()
+                    .and_then(|demangled| module.captures(demangled))
+                    .map(|captures| captures[1].to_owned());
+                criterion::black_box(module);
+            }
+        })
+    });
+
+    group.bench_function("swift_module_name", |b| {
+        b.iter(|| {
+            for name in &names {
+                criterion::black_box(swift_module_name(name.as_str()));
+            }
+        })
+    });
+
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_demangle,
+    bench_baseline,
+    bench_renderings,
+    bench_cache,
+    bench_detect_language,
+    bench_module_name
+);
+criterion_main!(benches);
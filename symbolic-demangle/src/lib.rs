@@ -34,29 +34,21 @@
 #![warn(missing_docs)]
 
 use std::borrow::Cow;
-#[cfg(feature = "swift")]
-use std::ffi::{CStr, CString};
-#[cfg(feature = "swift")]
-use std::os::raw::{c_char, c_int};
 
 use symbolic_common::{Language, Name, NameMangling};
 
 #[cfg(feature = "swift")]
-const SYMBOLIC_SWIFT_FEATURE_RETURN_TYPE: c_int = 0x1;
-#[cfg(feature = "swift")]
-const SYMBOLIC_SWIFT_FEATURE_PARAMETERS: c_int = 0x2;
+mod swift;
 
 #[cfg(feature = "swift")]
-extern "C" {
-    fn symbolic_demangle_swift(
-        sym: *const c_char,
-        buf: *mut c_char,
-        buf_len: usize,
-        features: c_int,
-    ) -> c_int;
-
-    fn symbolic_demangle_is_swift_symbol(sym: *const c_char) -> c_int;
-}
+pub use crate::swift::{
+    demangle_swift_baseline, demangle_swift_batch, demangle_swift_renderings,
+    has_swift_calling_convention, is_swift_thunk, swift_demangler_stats, swift_module_name,
+    swift_thunk_target, DemangledSwiftBatch, SwiftDemangleCache, SwiftDemangleCacheStats,
+    SwiftDemangleTree, SwiftDemanglerStats, SwiftNode, SwiftNodeChildren,
+};
+#[cfg(feature = "swift")]
+use crate::swift::{is_maybe_swift, try_demangle_swift};
 
 /// Options for [`Demangle::demangle`].
 ///
@@ -148,13 +140,6 @@ fn is_maybe_md5(ident: &str) -> bool {
         && ident[3..35].chars().all(|c| c.is_ascii_hexdigit())
 }
 
-#[cfg(feature = "swift")]
-fn is_maybe_swift(ident: &str) -> bool {
-    CString::new(ident)
-        .map(|cstr| unsafe { symbolic_demangle_is_swift_symbol(cstr.as_ptr()) != 0 })
-        .unwrap_or(false)
-}
-
 #[cfg(not(feature = "swift"))]
 fn is_maybe_swift(_ident: &str) -> bool {
     false
@@ -295,30 +280,6 @@ fn try_demangle_rust(_ident: &str, _opts: DemangleOptions) -> Option<String> {
     None
 }
 
-#[cfg(feature = "swift")]
-fn try_demangle_swift(ident: &str, opts: DemangleOptions) -> Option<String> {
-    let mut buf = vec![0; 4096];
-    let sym = match CString::new(ident) {
-        Ok(sym) => sym,
-        Err(_) => return None,
-    };
-
-    let mut features = 0;
-    if opts.return_type {
-        features |= SYMBOLIC_SWIFT_FEATURE_RETURN_TYPE;
-    }
-    if opts.parameters {
-        features |= SYMBOLIC_SWIFT_FEATURE_PARAMETERS;
-    }
-
-    unsafe {
-        match symbolic_demangle_swift(sym.as_ptr(), buf.as_mut_ptr(), buf.len(), features) {
-            0 => None,
-            _ => Some(CStr::from_ptr(buf.as_ptr()).to_string_lossy().to_string()),
-        }
-    }
-}
-
 #[cfg(not(feature = "swift"))]
 fn try_demangle_swift(_ident: &str, _opts: DemangleOptions) -> Option<String> {
     None
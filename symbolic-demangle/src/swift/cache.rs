@@ -0,0 +1,240 @@
+//! A bounded, sharded cache of demangled Swift names.
+
+use std::borrow::Borrow;
+use std::hash::{Hash, Hasher};
+use std::sync::{Arc, OnceLock};
+
+use symbolic_common::{ShardedCache, ShardedCacheStats};
+
+use crate::DemangleOptions;
+
+/// Approximate bookkeeping overhead of a cache entry in bytes, in addition to the strings.
+const ENTRY_OVERHEAD: usize = 64;
+
+static GLOBAL_CACHE: OnceLock<SwiftDemangleCache> = OnceLock::new();
+
+/// Statistics of a [`SwiftDemangleCache`].
+///
+/// `misses` counts the names that had to be passed to the demangler.
+pub type SwiftDemangleCacheStats = ShardedCacheStats;
+
+/// The mangled name and the demangle features it was demangled with.
+#[derive(Debug)]
+struct Key {
+    features: u8,
+    mangled: Box<str>,
+}
+
+/// The parts of a [`Key`], so that lookups do not need to allocate an owned key.
+trait KeyParts {
+    fn parts(&self) -> (u8, &str);
+}
+
+impl KeyParts for Key {
+    fn parts(&self) -> (u8, &str) {
+        (self.features, &self.mangled)
+    }
+}
+
+impl KeyParts for (u8, &str) {
+    fn parts(&self) -> (u8, &str) {
+        *self
+    }
+}
+
+impl<'a> Borrow<dyn KeyParts + 'a> for Key {
+    fn borrow(&self) -> &(dyn KeyParts + 'a) {
+        self
+    }
+}
+
+impl Hash for dyn KeyParts + '_ {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.parts().hash(state);
+    }
+}
+
+impl PartialEq for dyn KeyParts + '_ {
+    fn eq(&self, other: &Self) -> bool {
+        self.parts() == other.parts()
+    }
+}
+
+impl Eq for dyn KeyParts + '_ {}
+
+// `Hash` and `Eq` must agree with the borrowed form above.
+impl Hash for Key {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.parts().hash(state);
+    }
+}
+
+impl PartialEq for Key {
+    fn eq(&self, other: &Self) -> bool {
+        self.parts() == other.parts()
+    }
+}
+
+impl Eq for Key {}
+
+/// A bounded, concurrent cache of demangled Swift names.
+///
+/// Names are keyed by the mangled name and the [`DemangleOptions`] they were demangled with. The
+/// cache is split into independently locked shards and evicts entries once it exceeds its size
+/// budget, preferring entries that have not been hit recently.
+///
+/// A cache can be used directly through [`demangle`](Self::demangle), or installed as the
+/// process-wide cache with [`install`](Self::install). Once installed, all Swift names demangled
+/// through the [`Demangle`](crate::Demangle) trait go through the cache.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::{DemangleOptions, SwiftDemangleCache};
+///
+/// let cache = SwiftDemangleCache::new(1024 * 1024);
+/// let mangled = "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF";
+///
+/// assert_eq!(
+///     cache.demangle(mangled, DemangleOptions::name_only()).as_deref(),
+///     Some("GenericUnion.Foo<A>")
+/// );
+/// assert_eq!(
+///     cache.demangle(mangled, DemangleOptions::name_only()).as_deref(),
+///     Some("GenericUnion.Foo<A>")
+/// );
+///
+/// let stats = cache.stats();
+/// assert_eq!((stats.hits, stats.misses), (1, 1));
+/// ```
+#[derive(Debug)]
+pub struct SwiftDemangleCache {
+    cache: ShardedCache<Key, Option<Arc<str>>>,
+}
+
+impl SwiftDemangleCache {
+    /// Creates a new cache that holds approximately `budget` bytes of names.
+    pub fn new(budget: usize) -> Self {
+        Self {
+            cache: ShardedCache::new(budget),
+        }
+    }
+
+    /// Installs this cache as the process-wide Swift demangling cache.
+    ///
+    /// The process-wide cache can only be installed once. If a cache has been installed before,
+    /// this cache is returned as error.
+    pub fn install(self) -> Result<&'static Self, Self> {
+        let mut cache = Some(self);
+        let installed = GLOBAL_CACHE.get_or_init(|| cache.take().unwrap());
+        match cache {
+            Some(cache) => Err(cache),
+            None => Ok(installed),
+        }
+    }
+
+    /// Returns the process-wide Swift demangling cache, if one has been installed.
+    pub fn global() -> Option<&'static Self> {
+        GLOBAL_CACHE.get()
+    }
+
+    /// Demangles a Swift name, returning a cached result if available.
+    ///
+    /// This is equivalent to [`Demangle::demangle`](crate::Demangle::demangle) for a name with
+    /// [`Language::Swift`](symbolic_common::Language::Swift).
+    pub fn demangle(&self, ident: &str, opts: DemangleOptions) -> Option<String> {
+        self.get_or_insert_with(ident, opts, super::demangle_uncached)
+    }
+
+    pub(crate) fn get_or_insert_with<F>(
+        &self,
+        ident: &str,
+        opts: DemangleOptions,
+        demangle: F,
+    ) -> Option<String>
+    where
+        F: FnOnce(&str, DemangleOptions) -> Option<String>,
+    {
+        let features = super::swift_features(opts) as u8;
+        let parts: &dyn KeyParts = &(features, ident);
+        if let Some(demangled) = self.cache.get(parts) {
+            return demangled.as_deref().map(String::from);
+        }
+
+        // Demangle without holding a lock. Concurrent misses for the same name may demangle it
+        // more than once, but will produce the same result.
+        let demangled = demangle(ident, opts);
+
+        let size = ident.len() + demangled.as_ref().map_or(0, String::len) + ENTRY_OVERHEAD;
+        let key = Key {
+            features,
+            mangled: ident.into(),
+        };
+        self.cache
+            .insert(key, demangled.as_deref().map(Arc::from), size);
+
+        demangled
+    }
+
+    /// Returns hit, miss and eviction counters, as well as the current size of the cache.
+    pub fn stats(&self) -> SwiftDemangleCacheStats {
+        self.cache.stats()
+    }
+
+    /// Removes all entries from the cache, keeping the counters.
+    pub fn clear(&self) {
+        self.cache.clear();
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn test_cache_hits_and_options() {
+        let cache = SwiftDemangleCache::new(1024 * 1024);
+        let mangled = "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF";
+
+        let name_only = cache.demangle(mangled, DemangleOptions::name_only());
+        let complete = cache.demangle(mangled, DemangleOptions::complete());
+        assert_eq!(name_only.as_deref(), Some("GenericUnion.Foo<A>"));
+        assert_ne!(name_only, complete);
+
+        assert_eq!(
+            cache.demangle(mangled, DemangleOptions::name_only()),
+            name_only
+        );
+        assert_eq!(
+            cache.demangle(mangled, DemangleOptions::complete()),
+            complete
+        );
+
+        let stats = cache.stats();
+        assert_eq!(stats.hits, 2);
+        assert_eq!(stats.misses, 2);
+        assert_eq!(stats.evictions, 0);
+        assert_eq!(stats.entries, 2);
+    }
+
+    #[test]
+    fn test_cache_budget() {
+        let budget = 16 * 1024;
+        let cache = SwiftDemangleCache::new(budget);
+
+        for i in 0..1000 {
+            let mangled = format!("$s4main3fooyyF{i}");
+            cache.get_or_insert_with(&mangled, DemangleOptions::complete(), |ident, _| {
+                Some(ident.to_uppercase())
+            });
+        }
+
+        let stats = cache.stats();
+        assert!(stats.evictions > 0);
+        assert!(stats.bytes <= budget);
+        assert_eq!(stats.entries as u64, 1000 - stats.evictions);
+
+        cache.clear();
+        assert_eq!(cache.stats().entries, 0);
+    }
+}
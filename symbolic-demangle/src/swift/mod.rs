@@ -0,0 +1,544 @@
+//! Bindings to the vendored Swift demangler in `swiftdemangle.cpp`.
+
+use std::os::raw::{c_char, c_int, c_void};
+
+use crate::DemangleOptions;
+
+mod cache;
+mod tree;
+
+pub use cache::{SwiftDemangleCache, SwiftDemangleCacheStats};
+pub use tree::{SwiftDemangleTree, SwiftNode, SwiftNodeChildren};
+
+const SYMBOLIC_SWIFT_FEATURE_RETURN_TYPE: c_int = 0x1;
+const SYMBOLIC_SWIFT_FEATURE_PARAMETERS: c_int = 0x2;
+
+/// The maximum length of a demangled Swift name.
+///
+/// Pathological generic signatures can expand to enormous names. Printing stops at this length
+/// and the demangled name is truncated.
+const SWIFT_MAX_DEMANGLED_LEN: usize = 16 * 1024;
+
+type SwiftSink = unsafe extern "C" fn(sink_context: *mut c_void, data: *const c_char, len: usize);
+
+/// Allocation statistics of the Swift demangler, accumulated across all threads.
+///
+/// Every thread demangles Swift symbols on a preallocated arena and only falls back to heap
+/// allocations for symbols that do not fit. Use these statistics to check how often that happens.
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default, Eq, PartialEq)]
+pub struct SwiftDemanglerStats {
+    /// The number of demangled symbols.
+    pub symbols: u64,
+    /// The number of symbols that did not fit into the arena.
+    pub arena_overflows: u64,
+    /// The number of heap slabs allocated for symbols that did not fit into the arena.
+    pub slab_count: u64,
+    /// The total size of all heap slabs in bytes.
+    pub slab_bytes: u64,
+    /// The number of symbols by memory allocated for their nodes.
+    ///
+    /// The first bucket counts symbols that needed less than 512 bytes. Every further bucket
+    /// doubles that limit, and the last bucket counts all remaining symbols.
+    pub allocated_histogram: [u64; 12],
+}
+
+/// A borrowed, length-delimited string passed to the demangler.
+#[repr(C)]
+struct SwiftStr {
+    data: *const c_char,
+    len: usize,
+}
+
+impl SwiftStr {
+    fn new(s: &str) -> Self {
+        Self {
+            data: s.as_ptr() as *const c_char,
+            len: s.len(),
+        }
+    }
+}
+
+extern "C" {
+    fn symbolic_demangle_swift_to_sink(
+        sym: *const c_char,
+        sym_len: usize,
+        features: c_int,
+        max_len: usize,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_baseline(
+        sym: *const c_char,
+        sym_len: usize,
+        features: c_int,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+        stats: *mut SwiftDemanglerStats,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_batch(
+        syms: *const SwiftStr,
+        count: usize,
+        features: c_int,
+        max_len: usize,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+        offsets: *mut usize,
+    ) -> usize;
+
+    fn symbolic_demangle_swift_renderings(
+        sym: *const c_char,
+        sym_len: usize,
+        features: *const c_int,
+        count: usize,
+        max_len: usize,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+        offsets: *mut usize,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_module_name(
+        sym: *const c_char,
+        sym_len: usize,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_is_thunk(sym: *const c_char, sym_len: usize) -> c_int;
+
+    fn symbolic_demangle_swift_thunk_target(
+        sym: *const c_char,
+        sym_len: usize,
+        sink: SwiftSink,
+        sink_context: *mut c_void,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_has_swift_calling_convention(
+        sym: *const c_char,
+        sym_len: usize,
+    ) -> c_int;
+
+    fn symbolic_demangle_swift_stats(stats: *mut SwiftDemanglerStats);
+}
+
+fn swift_features(opts: DemangleOptions) -> c_int {
+    let mut features = 0;
+    if opts.return_type {
+        features |= SYMBOLIC_SWIFT_FEATURE_RETURN_TYPE;
+    }
+    if opts.parameters {
+        features |= SYMBOLIC_SWIFT_FEATURE_PARAMETERS;
+    }
+    features
+}
+
+/// Sink for `symbolic_demangle_swift_to_sink` that stores the output in an `Option<String>`.
+///
+/// The demangled name is copied exactly once, directly from the demangler's output.
+unsafe extern "C" fn swift_sink_string(sink_context: *mut c_void, data: *const c_char, len: usize) {
+    let output = &mut *(sink_context as *mut Option<String>);
+    let bytes = std::slice::from_raw_parts(data as *const u8, len);
+    *output = Some(String::from_utf8_lossy(bytes).into_owned());
+}
+
+/// Sink for `symbolic_demangle_swift_batch` that appends all output to a `Vec<u8>`.
+unsafe extern "C" fn swift_sink_bytes(sink_context: *mut c_void, data: *const c_char, len: usize) {
+    let output = &mut *(sink_context as *mut Vec<u8>);
+    let bytes = std::slice::from_raw_parts(data as *const u8, len);
+    output.extend_from_slice(bytes);
+}
+
+/// Checks whether the identifier starts with one of the Swift mangling prefixes.
+///
+/// This is equivalent to `swift::Demangle::isSwiftSymbol`, but does not need to cross into C++ or
+/// allocate a NUL-terminated copy of the name. The match on the leading bytes compiles down to a
+/// jump on the first byte followed by fixed-width comparisons.
+pub(crate) fn is_maybe_swift(ident: &str) -> bool {
+    match ident.as_bytes() {
+        // Swift < 4 uses `_T`, Swift 4 `_T0`
+        [b'_', b'T', ..] => true,
+        // Swift 4.x uses `$S`, Swift 5+ `$s`, each with an optional leading underscore
+        [b'$', b'S' | b's', ..] | [b'_', b'$', b'S' | b's', ..] => true,
+        // Swift 5+ for filenames
+        [b'@', rest @ ..] => rest.starts_with(b"__swiftmacro_"),
+        _ => false,
+    }
+}
+
+pub(crate) fn try_demangle_swift(ident: &str, opts: DemangleOptions) -> Option<String> {
+    match SwiftDemangleCache::global() {
+        Some(cache) => cache.demangle(ident, opts),
+        None => demangle_uncached(ident, opts),
+    }
+}
+
+fn demangle_uncached(ident: &str, opts: DemangleOptions) -> Option<String> {
+    let mut output: Option<String> = None;
+
+    unsafe {
+        symbolic_demangle_swift_to_sink(
+            ident.as_ptr() as *const c_char,
+            ident.len(),
+            swift_features(opts),
+            SWIFT_MAX_DEMANGLED_LEN,
+            swift_sink_string,
+            &mut output as *mut Option<String> as *mut c_void,
+        );
+    }
+
+    output
+}
+
+/// Demangles a Swift symbol with a fresh demangler context for every call.
+///
+/// This goes through `swift::Demangle::demangleSymbolAsString` without the per-thread arena and
+/// without limiting the length of the output. The heap slabs of the context are added to `stats`,
+/// since they do not show up in [`swift_demangler_stats`]. It only exists as a baseline for
+/// benchmarks.
+#[doc(hidden)]
+pub fn demangle_swift_baseline(
+    ident: &str,
+    opts: DemangleOptions,
+    stats: &mut SwiftDemanglerStats,
+) -> Option<String> {
+    let mut output: Option<String> = None;
+
+    unsafe {
+        symbolic_demangle_swift_baseline(
+            ident.as_ptr() as *const c_char,
+            ident.len(),
+            swift_features(opts),
+            swift_sink_string,
+            &mut output as *mut Option<String> as *mut c_void,
+            stats,
+        );
+    }
+
+    output
+}
+
+/// Calls a Swift demangler query that reports a string through a sink.
+fn query_string(
+    ident: &str,
+    query: unsafe extern "C" fn(*const c_char, usize, SwiftSink, *mut c_void) -> c_int,
+) -> Option<String> {
+    let mut output: Option<String> = None;
+
+    unsafe {
+        query(
+            ident.as_ptr() as *const c_char,
+            ident.len(),
+            swift_sink_string,
+            &mut output as *mut Option<String> as *mut c_void,
+        );
+    }
+
+    output
+}
+
+/// Returns the name of the module that defines a mangled Swift symbol.
+///
+/// This inspects the parse tree of the symbol without printing it, which is considerably cheaper
+/// than demangling the full name and extracting the module from it. Returns `None` if the symbol
+/// is not a valid Swift mangling or does not refer to an entity within a module, such as thunks.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::swift_module_name;
+///
+/// assert_eq!(
+///     swift_module_name("$s8mangling12GenericUnionO3FooyACyxGSicAEmlF").as_deref(),
+///     Some("mangling")
+/// );
+/// ```
+pub fn swift_module_name(ident: &str) -> Option<String> {
+    query_string(ident, symbolic_demangle_swift_module_name)
+}
+
+/// Returns `true` if the mangled Swift symbol is a thunk.
+///
+/// Thunks include partial application forwarders, reabstraction thunks, protocol witness thunks
+/// and thunks bridging between Swift and Objective-C.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::is_swift_thunk;
+///
+/// assert!(is_swift_thunk("$s4main3fooyyFTA"));
+/// assert!(!is_swift_thunk("$s4main3fooyyF"));
+/// ```
+pub fn is_swift_thunk(ident: &str) -> bool {
+    unsafe { symbolic_demangle_swift_is_thunk(ident.as_ptr() as *const c_char, ident.len()) != 0 }
+}
+
+/// Returns the mangled name of the function called by a Swift thunk.
+///
+/// Returns `None` if the symbol is not a thunk, or if its target cannot be derived from the
+/// mangled name, as is the case for reabstraction and protocol witness thunks.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::swift_thunk_target;
+///
+/// assert_eq!(
+///     swift_thunk_target("$s4main3fooyyFTA").as_deref(),
+///     Some("$s4main3fooyyF")
+/// );
+/// ```
+pub fn swift_thunk_target(ident: &str) -> Option<String> {
+    query_string(ident, symbolic_demangle_swift_thunk_target)
+}
+
+/// Returns `true` if the mangled Swift function uses the Swift calling convention.
+///
+/// This is `false` for symbols that cannot be demangled, and for functions such as type metadata
+/// accessors and value witnesses, which use the C calling convention.
+pub fn has_swift_calling_convention(ident: &str) -> bool {
+    unsafe {
+        symbolic_demangle_swift_has_swift_calling_convention(
+            ident.as_ptr() as *const c_char,
+            ident.len(),
+        ) != 0
+    }
+}
+
+/// Returns allocation statistics of the Swift demangler.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::{Language, Name, NameMangling};
+/// use symbolic_demangle::{swift_demangler_stats, Demangle, DemangleOptions};
+///
+/// let name = Name::new("$s8mangling6curry1yyF", NameMangling::Mangled, Language::Swift);
+/// name.demangle(DemangleOptions::complete());
+///
+/// let stats = swift_demangler_stats();
+/// assert!(stats.symbols > 0);
+/// ```
+pub fn swift_demangler_stats() -> SwiftDemanglerStats {
+    let mut stats = SwiftDemanglerStats::default();
+    unsafe { symbolic_demangle_swift_stats(&mut stats) };
+    stats
+}
+
+/// Demangled Swift names returned by [`demangle_swift_batch`] and [`demangle_swift_renderings`].
+///
+/// All names are stored in a single packed buffer, indexed by their position in the input.
+#[derive(Clone, Debug, Default)]
+pub struct DemangledSwiftBatch {
+    buffer: String,
+    offsets: Vec<usize>,
+}
+
+impl DemangledSwiftBatch {
+    /// Creates a batch from the demangler's packed output and the offsets of all names within it.
+    fn from_parts(buffer: Vec<u8>, offsets: Vec<usize>) -> Self {
+        match String::from_utf8(buffer) {
+            Ok(buffer) => Self { buffer, offsets },
+            Err(error) => {
+                // Replace invalid UTF-8 per name, which shifts all subsequent offsets.
+                let bytes = error.into_bytes();
+                let mut buffer = String::with_capacity(bytes.len());
+                let mut lossy_offsets = Vec::with_capacity(offsets.len());
+                lossy_offsets.push(0);
+                for range in offsets.windows(2) {
+                    buffer.push_str(&String::from_utf8_lossy(&bytes[range[0]..range[1]]));
+                    lossy_offsets.push(buffer.len());
+                }
+                Self {
+                    buffer,
+                    offsets: lossy_offsets,
+                }
+            }
+        }
+    }
+
+    /// Returns the number of names in this batch, including names that failed to demangle.
+    pub fn len(&self) -> usize {
+        self.offsets.len().saturating_sub(1)
+    }
+
+    /// Returns `true` if this batch contains no names.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns the demangled name at the given index.
+    ///
+    /// Returns `None` if the index is out of bounds or if the name was empty. Names that could not
+    /// be demangled are usually returned unchanged, see [`demangle_swift_batch`].
+    pub fn get(&self, index: usize) -> Option<&str> {
+        let start = *self.offsets.get(index)?;
+        let end = *self.offsets.get(index + 1)?;
+        if start == end {
+            return None;
+        }
+        Some(&self.buffer[start..end])
+    }
+
+    /// Returns an iterator over all demangled names in input order.
+    pub fn iter(&self) -> impl Iterator<Item = Option<&str>> + '_ {
+        (0..self.len()).map(move |index| self.get(index))
+    }
+}
+
+/// Demangles a batch of Swift symbols in a single call into the Swift demangler.
+///
+/// This is equivalent to calling [`Demangle::demangle`] on every name with
+/// [`Language::Swift`], but all names share a single demangler and the results are written into
+/// one packed buffer. Use this when demangling entire function tables.
+///
+/// As with [`Demangle::demangle`], names that are not valid Swift manglings are usually returned
+/// unchanged.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::{demangle_swift_batch, DemangleOptions};
+///
+/// let batch = demangle_swift_batch(
+///     &["$s8mangling12GenericUnionO3FooyACyxGSicAEmlF", "$s8mangling6curry1yyF"],
+///     DemangleOptions::name_only(),
+/// );
+///
+/// assert_eq!(batch.get(0), Some("GenericUnion.Foo<A>"));
+/// assert_eq!(batch.get(1), Some("curry1"));
+/// ```
+///
+/// [`Demangle::demangle`]: crate::Demangle::demangle
+/// [`Language::Swift`]: symbolic_common::Language::Swift
+pub fn demangle_swift_batch<S: AsRef<str>>(
+    names: &[S],
+    opts: DemangleOptions,
+) -> DemangledSwiftBatch {
+    let symbols: Vec<SwiftStr> = names.iter().map(|n| SwiftStr::new(n.as_ref())).collect();
+    let mut offsets = vec![0; symbols.len() + 1];
+    let mut buffer = Vec::with_capacity(symbols.iter().map(|s| s.len).sum());
+
+    unsafe {
+        symbolic_demangle_swift_batch(
+            symbols.as_ptr(),
+            symbols.len(),
+            swift_features(opts),
+            SWIFT_MAX_DEMANGLED_LEN,
+            swift_sink_bytes,
+            &mut buffer as *mut Vec<u8> as *mut c_void,
+            offsets.as_mut_ptr(),
+        );
+    }
+
+    DemangledSwiftBatch::from_parts(buffer, offsets)
+}
+
+/// Demangles a Swift symbol once and renders it with several sets of options.
+///
+/// This is equivalent to calling [`Demangle::demangle`] once for every entry in `options`, but the
+/// symbol is parsed only once and all renderings are printed from the same demangle tree. The
+/// renderings are returned in the order of `options`.
+///
+/// Returns `None` if the symbol cannot be demangled.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::{demangle_swift_renderings, DemangleOptions};
+///
+/// let renderings = demangle_swift_renderings(
+///     "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF",
+///     &[DemangleOptions::complete(), DemangleOptions::name_only()],
+/// )
+/// .unwrap();
+///
+/// assert_eq!(
+///     renderings.get(0),
+///     Some("mangling.GenericUnion.Foo<A>(Swift.Int) -> mangling.GenericUnion<A>")
+/// );
+/// assert_eq!(renderings.get(1), Some("GenericUnion.Foo<A>"));
+/// ```
+///
+/// [`Demangle::demangle`]: crate::Demangle::demangle
+pub fn demangle_swift_renderings(
+    ident: &str,
+    options: &[DemangleOptions],
+) -> Option<DemangledSwiftBatch> {
+    let features: Vec<c_int> = options.iter().map(|opts| swift_features(*opts)).collect();
+    let mut offsets = vec![0; features.len() + 1];
+    let mut buffer = Vec::with_capacity(ident.len() * features.len());
+
+    let demangled = unsafe {
+        symbolic_demangle_swift_renderings(
+            ident.as_ptr() as *const c_char,
+            ident.len(),
+            features.as_ptr(),
+            features.len(),
+            SWIFT_MAX_DEMANGLED_LEN,
+            swift_sink_bytes,
+            &mut buffer as *mut Vec<u8> as *mut c_void,
+            offsets.as_mut_ptr(),
+        )
+    };
+
+    (demangled != 0).then(|| DemangledSwiftBatch::from_parts(buffer, offsets))
+}
+
+#[cfg(test)]
+mod test {
+    use std::ffi::CString;
+
+    use super::*;
+
+    extern "C" {
+        fn symbolic_demangle_is_swift_symbol(sym: *const c_char) -> c_int;
+    }
+
+    #[test]
+    fn test_is_maybe_swift_matches_demangler() {
+        let candidates = [
+            "",
+            "_",
+            "_T",
+            "_T0",
+            "_T08mangling6curry1yyF",
+            "_TtC5Hello8Greeting",
+            "$",
+            "$S",
+            "$s",
+            "$x",
+            "$s8mangling6curry1yyF",
+            "$S8mangling6curry1yyF",
+            "_$",
+            "_$s",
+            "_$S8mangling6curry1yyF",
+            "_$s8mangling6curry1yyF",
+            "_$x",
+            "@__swiftmacro_",
+            "@__swiftmacro_1a13testStringifyAA10stringifyfMf_",
+            "@__swiftmacro",
+            "@__swift",
+            "@_swiftmacro_",
+            "_Z1hic",
+            "__ZN3std2io4Read11read_to_end17hb85a0f6802e14499E",
+            "?h@@YAXH@Z",
+            "-[NSObject init]",
+            "main",
+            "_main",
+            "__T0",
+            "T0",
+            "s8mangling6curry1yyF",
+        ];
+
+        for candidate in candidates {
+            let expected = unsafe {
+                let cstr = CString::new(candidate).unwrap();
+                symbolic_demangle_is_swift_symbol(cstr.as_ptr()) != 0
+            };
+            assert_eq!(is_maybe_swift(candidate), expected, "{candidate:?}");
+        }
+    }
+}
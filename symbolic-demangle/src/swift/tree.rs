@@ -0,0 +1,302 @@
+//! Structured access to the demangle tree of Swift symbols.
+
+use std::ffi::CStr;
+use std::fmt;
+use std::os::raw::c_char;
+
+const PAYLOAD_TEXT: u8 = 1;
+const PAYLOAD_INDEX: u8 = 2;
+
+/// Parent index of the root node.
+const NO_PARENT: u32 = u32::MAX;
+
+/// A node as written by `symbolic_demangle_swift_tree`.
+#[repr(C)]
+#[derive(Clone, Copy, Debug)]
+struct RawNode {
+    index: u64,
+    parent: u32,
+    subtree_end: u32,
+    text_offset: u32,
+    text_len: u32,
+    kind: u16,
+    payload: u8,
+}
+
+extern "C" {
+    fn symbolic_demangle_swift_tree(
+        sym: *const c_char,
+        sym_len: usize,
+        nodes: *mut RawNode,
+        node_capacity: usize,
+        text: *mut u8,
+        text_capacity: usize,
+        text_len: *mut usize,
+    ) -> usize;
+
+    fn symbolic_demangle_swift_node_kind(kind: u16) -> *const c_char;
+}
+
+/// The demangle tree of a Swift symbol.
+///
+/// The Swift demangler parses a mangled name into a tree of nodes before printing it. This type
+/// exposes that tree as a flat array, so that structural information such as the module, type
+/// name, or generic arguments of a symbol can be read without parsing the printed name.
+///
+/// Nodes are stored in pre-order, starting with the root node at index `0`. A tree can be reused
+/// for many symbols with [`demangle`](Self::demangle), which keeps its buffers allocated.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_demangle::SwiftDemangleTree;
+///
+/// let tree = SwiftDemangleTree::parse("$s4main3fooyyF").unwrap();
+/// let identifier = tree.iter().find(|node| node.kind() == "Identifier").unwrap();
+/// assert_eq!(identifier.text(), Some("foo"));
+/// ```
+#[derive(Clone, Default)]
+pub struct SwiftDemangleTree {
+    nodes: Vec<RawNode>,
+    text: Vec<u8>,
+}
+
+impl SwiftDemangleTree {
+    /// Creates an empty tree.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Parses the demangle tree of a mangled Swift symbol.
+    ///
+    /// Returns `None` if the symbol cannot be demangled.
+    pub fn parse(ident: &str) -> Option<Self> {
+        let mut tree = Self {
+            nodes: Vec::with_capacity(64),
+            text: Vec::with_capacity(256),
+        };
+
+        tree.demangle(ident).then_some(tree)
+    }
+
+    /// Replaces the contents of this tree with the demangle tree of `ident`.
+    ///
+    /// Returns `false` and leaves the tree empty if the symbol cannot be demangled.
+    pub fn demangle(&mut self, ident: &str) -> bool {
+        self.nodes.clear();
+        self.text.clear();
+
+        loop {
+            let mut text_len = 0;
+            let node_count = unsafe {
+                symbolic_demangle_swift_tree(
+                    ident.as_ptr() as *const c_char,
+                    ident.len(),
+                    self.nodes.as_mut_ptr(),
+                    self.nodes.capacity(),
+                    self.text.as_mut_ptr(),
+                    self.text.capacity(),
+                    &mut text_len,
+                )
+            };
+
+            if node_count == 0 {
+                return false;
+            }
+
+            if node_count <= self.nodes.capacity() && text_len <= self.text.capacity() {
+                // SAFETY: The demangler has initialized all nodes and text within capacity.
+                unsafe {
+                    self.nodes.set_len(node_count);
+                    self.text.set_len(text_len);
+                }
+                return true;
+            }
+
+            self.nodes.reserve(node_count);
+            self.text.reserve(text_len);
+        }
+    }
+
+    /// Returns the number of nodes in the tree.
+    pub fn len(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// Returns `true` if the tree contains no nodes.
+    pub fn is_empty(&self) -> bool {
+        self.nodes.is_empty()
+    }
+
+    /// Returns the root node, or `None` if the tree is empty.
+    pub fn root(&self) -> Option<SwiftNode<'_>> {
+        self.get(0)
+    }
+
+    /// Returns the node at the given position in pre-order.
+    pub fn get(&self, id: usize) -> Option<SwiftNode<'_>> {
+        (id < self.nodes.len()).then_some(SwiftNode { tree: self, id })
+    }
+
+    /// Returns an iterator over all nodes in pre-order.
+    pub fn iter(&self) -> impl Iterator<Item = SwiftNode<'_>> {
+        (0..self.nodes.len()).map(move |id| SwiftNode { tree: self, id })
+    }
+}
+
+impl fmt::Debug for SwiftDemangleTree {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_list().entries(self.iter()).finish()
+    }
+}
+
+/// A node in a [`SwiftDemangleTree`].
+#[derive(Clone, Copy)]
+pub struct SwiftNode<'a> {
+    tree: &'a SwiftDemangleTree,
+    id: usize,
+}
+
+impl<'a> SwiftNode<'a> {
+    fn raw(&self) -> &'a RawNode {
+        &self.tree.nodes[self.id]
+    }
+
+    /// Returns the position of this node in the tree.
+    pub fn id(&self) -> usize {
+        self.id
+    }
+
+    /// Returns the numeric kind of this node.
+    ///
+    /// Kind values depend on the version of the Swift demangler and should not be persisted. Use
+    /// [`kind`](Self::kind) to compare against a specific kind.
+    pub fn kind_id(&self) -> u16 {
+        self.raw().kind
+    }
+
+    /// Returns the name of this node's kind, such as `"Function"` or `"Identifier"`.
+    pub fn kind(&self) -> &'static str {
+        let name = unsafe { CStr::from_ptr(symbolic_demangle_swift_node_kind(self.raw().kind)) };
+        name.to_str().unwrap_or_default()
+    }
+
+    /// Returns the text of this node, if it has any.
+    ///
+    /// This also returns `None` if the text is not valid UTF-8.
+    pub fn text(&self) -> Option<&'a str> {
+        let raw = self.raw();
+        if raw.payload != PAYLOAD_TEXT {
+            return None;
+        }
+
+        let start = raw.text_offset as usize;
+        let end = start + raw.text_len as usize;
+        std::str::from_utf8(&self.tree.text[start..end]).ok()
+    }
+
+    /// Returns the numeric payload of this node, if it has one.
+    pub fn index(&self) -> Option<u64> {
+        let raw = self.raw();
+        (raw.payload == PAYLOAD_INDEX).then_some(raw.index)
+    }
+
+    /// Returns the parent of this node, or `None` for the root node.
+    pub fn parent(&self) -> Option<SwiftNode<'a>> {
+        match self.raw().parent {
+            NO_PARENT => None,
+            parent => self.tree.get(parent as usize),
+        }
+    }
+
+    /// Returns the child of this node at the given position.
+    pub fn child(&self, index: usize) -> Option<SwiftNode<'a>> {
+        self.children().nth(index)
+    }
+
+    /// Returns an iterator over the direct children of this node.
+    pub fn children(&self) -> SwiftNodeChildren<'a> {
+        SwiftNodeChildren {
+            tree: self.tree,
+            next: self.id + 1,
+            end: self.raw().subtree_end as usize,
+        }
+    }
+
+    /// Returns an iterator over all descendants of this node in pre-order.
+    pub fn descendants(&self) -> impl Iterator<Item = SwiftNode<'a>> {
+        let tree = self.tree;
+        (self.id + 1..self.raw().subtree_end as usize).map(move |id| SwiftNode { tree, id })
+    }
+}
+
+impl fmt::Debug for SwiftNode<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let mut debug = f.debug_struct("SwiftNode");
+        debug.field("id", &self.id).field("kind", &self.kind());
+        if let Some(text) = self.text() {
+            debug.field("text", &text);
+        }
+        if let Some(index) = self.index() {
+            debug.field("index", &index);
+        }
+        debug.finish()
+    }
+}
+
+/// An iterator over the children of a [`SwiftNode`].
+#[derive(Clone, Debug)]
+pub struct SwiftNodeChildren<'a> {
+    tree: &'a SwiftDemangleTree,
+    next: usize,
+    end: usize,
+}
+
+impl<'a> Iterator for SwiftNodeChildren<'a> {
+    type Item = SwiftNode<'a>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.next >= self.end {
+            return None;
+        }
+
+        let node = SwiftNode {
+            tree: self.tree,
+            id: self.next,
+        };
+        self.next = node.raw().subtree_end as usize;
+        Some(node)
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn test_tree_structure() {
+        let tree = SwiftDemangleTree::parse("$s4main3fooyyF").unwrap();
+        let root = tree.root().unwrap();
+        assert_eq!(root.kind(), "Global");
+        assert!(root.parent().is_none());
+        assert_eq!(root.descendants().count(), tree.len() - 1);
+
+        for node in tree.iter().skip(1) {
+            let parent = node.parent().unwrap();
+            assert!(parent.children().any(|child| child.id() == node.id()));
+        }
+    }
+
+    #[test]
+    fn test_tree_reuse() {
+        let mut tree = SwiftDemangleTree::new();
+        assert!(tree.demangle("$s8mangling12GenericUnionO3FooyACyxGSicAEmlF"));
+        let len = tree.len();
+
+        assert!(!tree.demangle("xyz"));
+        assert!(tree.is_empty());
+
+        assert!(tree.demangle("$s8mangling12GenericUnionO3FooyACyxGSicAEmlF"));
+        assert_eq!(tree.len(), len);
+    }
+}
@@ -1,13 +1,213 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "swift/Demangling/Demangle.h"
+#include "swift/Demangling/Demangler.h"
 
 #define SYMBOLIC_SWIFT_FEATURE_RETURN_TYPE 0x1
 #define SYMBOLIC_SWIFT_FEATURE_PARAMETERS 0x2
 #define SYMBOLIC_SWIFT_FEATURE_ALL 0x3
 
-extern "C" int symbolic_demangle_swift(const char *symbol,
-                                       char *buffer,
-                                       size_t buffer_length,
-                                       int features) {
+/// Size of the per-thread arena that demangler nodes are allocated from.
+///
+/// Demangling the symbols in our Swift test corpus allocates between 0.5 and
+/// 4 KiB of nodes, with almost all symbols below 2 KiB. Symbols that do not fit
+/// fall back to heap slabs, which are released again after the symbol. Use the
+/// histogram in `symbolic_demangle_swift_stats` to tune this value.
+#ifndef SYMBOLIC_SWIFT_ARENA_SIZE
+#define SYMBOLIC_SWIFT_ARENA_SIZE (8 * 1024)
+#endif
+
+#define SYMBOLIC_SWIFT_HISTOGRAM_BUCKETS 12
+
+/// Statistics on node allocations of the demangler, across all threads.
+struct symbolic_swift_stats {
+    /// The number of demangled symbols.
+    uint64_t symbols;
+    /// The number of symbols that did not fit into the arena.
+    uint64_t arena_overflows;
+    /// The number of heap slabs allocated for symbols that did not fit.
+    uint64_t slab_count;
+    /// The total size of all heap slabs.
+    uint64_t slab_bytes;
+    /// Number of symbols by bytes allocated for their nodes. Bucket 0 counts
+    /// symbols below 512 bytes, every further bucket doubles the limit, and the
+    /// last bucket counts everything else.
+    uint64_t allocated_histogram[SYMBOLIC_SWIFT_HISTOGRAM_BUCKETS];
+};
+
+/// Counters behind `symbolic_swift_stats` for a single thread.
+///
+/// Only the owning thread writes the counters, so it updates them with a
+/// relaxed load and store instead of a read-modify-write. They are atomic so
+/// that `symbolic_demangle_swift_stats` can read them from other threads. The
+/// counters fill their own cache lines, so threads never contend on them.
+struct alignas(64) ThreadStats {
+    std::atomic<uint64_t> symbols{0};
+    std::atomic<uint64_t> arena_overflows{0};
+    std::atomic<uint64_t> slab_count{0};
+    std::atomic<uint64_t> slab_bytes{0};
+    std::atomic<uint64_t> allocated_histogram[SYMBOLIC_SWIFT_HISTOGRAM_BUCKETS] =
+        {};
+
+    static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    /// Adds these counters to `stats`.
+    void sum_into(symbolic_swift_stats &stats) const {
+        stats.symbols += symbols.load(std::memory_order_relaxed);
+        stats.arena_overflows += arena_overflows.load(std::memory_order_relaxed);
+        stats.slab_count += slab_count.load(std::memory_order_relaxed);
+        stats.slab_bytes += slab_bytes.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < SYMBOLIC_SWIFT_HISTOGRAM_BUCKETS; i++) {
+            stats.allocated_histogram[i] +=
+                allocated_histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+/// The counters of all threads with a demangling state.
+///
+/// Threads register their counters on first use and fold them into `retired`
+/// when they exit, so the lock is never taken while demangling.
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<const ThreadStats *> threads;
+    symbolic_swift_stats retired = {};
+
+    /// Returns the registry, which is intentionally leaked so that threads
+    /// exiting during static destruction can still retire their counters.
+    static StatsRegistry &get() {
+        static StatsRegistry *registry = new StatsRegistry;
+        return *registry;
+    }
+
+    void add(const ThreadStats *stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(stats);
+    }
+
+    void retire(const ThreadStats *stats) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats->sum_into(retired);
+        threads.erase(std::find(threads.begin(), threads.end(), stats));
+    }
+
+    symbolic_swift_stats sum() {
+        std::lock_guard<std::mutex> lock(mutex);
+        symbolic_swift_stats total = retired;
+        for (const ThreadStats *stats : threads) {
+            stats->sum_into(total);
+        }
+        return total;
+    }
+};
+
+static size_t histogram_bucket(size_t allocated) {
+    size_t bucket = 0;
+    for (size_t limit = 512; allocated >= limit; limit *= 2) {
+        if (++bucket == SYMBOLIC_SWIFT_HISTOGRAM_BUCKETS - 1) {
+            break;
+        }
+    }
+    return bucket;
+}
+
+/// Per-thread demangler state that is reused across symbols.
+///
+/// `swift::Demangle::demangleSymbolAsString` creates a new `Context` for every
+/// call, which allocates a fresh `Demangler` and mallocs its node slabs from
+/// scratch. Keeping one context per thread and clearing it after every symbol
+/// recycles the largest slab instead, so that after a few symbols demangling
+/// converges to a single allocation that is reused indefinitely. The same
+/// applies to the buffer the demangled name is printed into.
+///
+/// Nodes are allocated from a preallocated arena first, so that common symbols
+/// never reach malloc.
+struct DemangleState {
+    std::unique_ptr<char[]> arena;
+    swift::Demangle::Context context;
+    std::string output;
+    ThreadStats stats;
+
+    DemangleState() : arena(new char[SYMBOLIC_SWIFT_ARENA_SIZE]) {
+        context.getNodeFactory().providePreallocatedMemory(
+            arena.get(), SYMBOLIC_SWIFT_ARENA_SIZE);
+        StatsRegistry::get().add(&stats);
+    }
+
+    ~DemangleState() { StatsRegistry::get().retire(&stats); }
+
+    DemangleState(const DemangleState &) = delete;
+    DemangleState &operator=(const DemangleState &) = delete;
+
+    /// Records allocation statistics of the current symbol and clears the
+    /// context for the next one.
+    void clear() {
+        swift::Demangle::NodeFactory &factory = context.getNodeFactory();
+        const swift::Demangle::NodeFactory::Statistics &factory_stats =
+            factory.getStatistics();
+
+        ThreadStats::add(stats.symbols, 1);
+        ThreadStats::add(
+            stats.allocated_histogram[histogram_bucket(
+                factory_stats.AllocatedBytes)],
+            1);
+
+        if (factory_stats.SlabCount != recorded_slab_count) {
+            ThreadStats::add(stats.arena_overflows, 1);
+            ThreadStats::add(stats.slab_count,
+                             factory_stats.SlabCount - recorded_slab_count);
+            ThreadStats::add(stats.slab_bytes,
+                             factory_stats.SlabBytes - recorded_slab_bytes);
+            recorded_slab_count = factory_stats.SlabCount;
+            recorded_slab_bytes = factory_stats.SlabBytes;
+        }
+
+        context.clear();
+    }
+
+  private:
+    size_t recorded_slab_count = 0;
+    size_t recorded_slab_bytes = 0;
+};
+
+static DemangleState &thread_state() {
+    thread_local DemangleState state;
+    return state;
+}
+
+/// Clears the thread's demangling context when going out of scope.
+///
+/// Nodes and strings returned by the context are only valid until then.
+class ContextGuard {
+  public:
+    ContextGuard() : state_(thread_state()) {}
+    ~ContextGuard() { state_.clear(); }
+
+    DemangleState &operator*() { return state_; }
+    DemangleState *operator->() { return &state_; }
+
+  private:
+    DemangleState &state_;
+};
+
+/// Receives demangled output from the demangler.
+///
+/// The sink is invoked with the complete demangled name. `data` is not NUL
+/// terminated and only valid for the duration of the call.
+typedef void (*symbolic_swift_sink)(void *sink_context,
+                                    const char *data,
+                                    size_t length);
+
+static swift::Demangle::DemangleOptions demangle_options(int features) {
     swift::Demangle::DemangleOptions opts;
 
     if (features < SYMBOLIC_SWIFT_FEATURE_ALL) {
@@ -19,10 +219,56 @@ extern "C" int symbolic_demangle_swift(const char *symbol,
         opts.ShowFunctionArgumentTypes = argument_types;
     }
 
-    std::string demangled =
-        swift::Demangle::demangleSymbolAsString(llvm::StringRef(symbol), opts);
+    return opts;
+}
 
-    if (demangled.size() == 0 || demangled.size() >= buffer_length) {
+/// Prints the demangle tree `root` of `symbol` into `state.output`, printing
+/// at most `max_length` bytes.
+///
+/// Like `Context::demangleSymbolAsString`, this falls back to the mangled name
+/// if the symbol cannot be demangled. Demangled names that exceed `max_length`
+/// are cut off at a UTF-8 character boundary.
+///
+/// Returns `true` if the demangled name was truncated.
+static bool print_symbol(DemangleState &state,
+                         swift::Demangle::NodePointer root,
+                         llvm::StringRef symbol,
+                         const swift::Demangle::DemangleOptions &opts,
+                         size_t max_length) {
+    bool truncated;
+    if (!swift::Demangle::nodeToBoundedString(root, state.output, max_length,
+                                              truncated, opts) ||
+        state.output.empty()) {
+        state.output.assign(symbol.data(), symbol.size());
+        return false;
+    }
+
+    return truncated;
+}
+
+/// Demangles `symbol` into `state.output`. See `print_symbol`.
+static bool demangle_symbol(DemangleState &state,
+                            llvm::StringRef symbol,
+                            const swift::Demangle::DemangleOptions &opts,
+                            size_t max_length) {
+    swift::Demangle::NodePointer root =
+        state.context.demangleSymbolAsNode(symbol);
+    return print_symbol(state, root, symbol, opts, max_length);
+}
+
+extern "C" int symbolic_demangle_swift(const char *symbol,
+                                       char *buffer,
+                                       size_t buffer_length,
+                                       int features) {
+    swift::Demangle::DemangleOptions opts = demangle_options(features);
+
+    ContextGuard state;
+    bool truncated =
+        demangle_symbol(*state, llvm::StringRef(symbol), opts, buffer_length);
+    const std::string &demangled = state->output;
+
+    if (truncated || demangled.size() == 0 ||
+        demangled.size() >= buffer_length) {
         return false;
     }
 
@@ -31,6 +277,338 @@ extern "C" int symbolic_demangle_swift(const char *symbol,
     return true;
 }
 
+/// Demangles a symbol of the given length and passes the result to `sink`.
+///
+/// Unlike `symbolic_demangle_swift`, the symbol does not need to be NUL
+/// terminated and the output is not limited by a fixed-size buffer. The sink
+/// is invoked exactly once if demangling succeeds, and not at all otherwise.
+/// Printing stops once the demangled name reaches `max_length` bytes, and the
+/// truncated name is passed to the sink.
+extern "C" int symbolic_demangle_swift_to_sink(const char *symbol,
+                                               size_t symbol_length,
+                                               int features,
+                                               size_t max_length,
+                                               symbolic_swift_sink sink,
+                                               void *sink_context) {
+    swift::Demangle::DemangleOptions opts = demangle_options(features);
+
+    ContextGuard state;
+    demangle_symbol(*state, llvm::StringRef(symbol, symbol_length), opts,
+                    max_length);
+    const std::string &demangled = state->output;
+
+    if (demangled.size() == 0) {
+        return false;
+    }
+
+    sink(sink_context, demangled.data(), demangled.size());
+    return true;
+}
+
+/// Demangles a symbol with a fresh `swift::Demangle::Context` and passes the
+/// result to `sink`.
+///
+/// This is the body of `swift::Demangle::demangleSymbolAsString`, which sets up
+/// and tears down a demangler for every call and allocates all node slabs on
+/// the heap. The context is spelled out so that its slabs can be added to
+/// `stats`, where every symbol counts as an arena overflow. Only used as a
+/// baseline in benchmarks.
+extern "C" int symbolic_demangle_swift_baseline(const char *symbol,
+                                                size_t symbol_length,
+                                                int features,
+                                                symbolic_swift_sink sink,
+                                                void *sink_context,
+                                                symbolic_swift_stats *stats) {
+    swift::Demangle::DemangleOptions opts = demangle_options(features);
+
+    swift::Demangle::Context context;
+    std::string demangled = context.demangleSymbolAsString(
+        llvm::StringRef(symbol, symbol_length), opts);
+
+    const swift::Demangle::NodeFactory::Statistics &factory_stats =
+        context.getNodeFactory().getStatistics();
+    stats->symbols += 1;
+    stats->arena_overflows += factory_stats.SlabCount > 0;
+    stats->slab_count += factory_stats.SlabCount;
+    stats->slab_bytes += factory_stats.SlabBytes;
+
+    if (demangled.size() == 0) {
+        return false;
+    }
+
+    sink(sink_context, demangled.data(), demangled.size());
+    return true;
+}
+
+/// A borrowed, length-delimited string.
+struct symbolic_swift_str {
+    const char *data;
+    size_t length;
+};
+
+/// Demangles a batch of symbols into a single packed output arena.
+///
+/// All demangled names are passed to `sink` in order, which is expected to
+/// append them to a contiguous buffer. `offsets` must point to `count + 1`
+/// elements and receives the start offset of every demangled name in that
+/// buffer, followed by the total length. Every name is limited to `max_length`
+/// bytes.
+///
+/// Like `symbolic_demangle_swift_to_sink`, symbols that cannot be demangled
+/// fall back to the mangled name, so they do not produce an empty range. Only
+/// empty symbols do.
+///
+/// All symbols share the thread's demangling context, so its node slab is
+/// allocated once for the entire batch.
+///
+/// Returns the number of non-empty names passed to `sink`, including mangled
+/// names that were passed through unchanged.
+extern "C" size_t symbolic_demangle_swift_batch(const symbolic_swift_str *symbols,
+                                                size_t count,
+                                                int features,
+                                                size_t max_length,
+                                                symbolic_swift_sink sink,
+                                                void *sink_context,
+                                                size_t *offsets) {
+    swift::Demangle::DemangleOptions opts = demangle_options(features);
+
+    size_t written_count = 0;
+    offsets[0] = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        ContextGuard state;
+        demangle_symbol(*state,
+                        llvm::StringRef(symbols[i].data, symbols[i].length),
+                        opts, max_length);
+        const std::string &demangled = state->output;
+
+        if (demangled.size() > 0) {
+            sink(sink_context, demangled.data(), demangled.size());
+            written_count++;
+        }
+
+        offsets[i + 1] = offsets[i] + demangled.size();
+    }
+
+    return written_count;
+}
+
+/// Demangles `symbol` once and prints it with several sets of features.
+///
+/// `features` points to `count` feature sets. The renderings are passed to
+/// `sink` in the same order, and `offsets` receives their start offsets
+/// followed by the total length, as in `symbolic_demangle_swift_batch`. The
+/// symbol is parsed only once, and all renderings print the same node tree.
+///
+/// Returns `false` if the symbol could not be demangled. Like the other entry
+/// points, the mangled name is passed to `sink` for every rendering instead.
+extern "C" int symbolic_demangle_swift_renderings(const char *symbol,
+                                                  size_t symbol_length,
+                                                  const int *features,
+                                                  size_t count,
+                                                  size_t max_length,
+                                                  symbolic_swift_sink sink,
+                                                  void *sink_context,
+                                                  size_t *offsets) {
+    ContextGuard state;
+    llvm::StringRef mangled(symbol, symbol_length);
+    swift::Demangle::NodePointer root =
+        state->context.demangleSymbolAsNode(mangled);
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        print_symbol(*state, root, mangled, demangle_options(features[i]),
+                     max_length);
+        const std::string &demangled = state->output;
+        sink(sink_context, demangled.data(), demangled.size());
+        offsets[i + 1] = offsets[i] + demangled.size();
+    }
+
+    return root != nullptr;
+}
+
+/// Passes the name of the module that defines `symbol` to `sink`.
+///
+/// This only walks the parse tree and is much cheaper than printing the
+/// demangled name. Returns `false` if the module cannot be determined.
+extern "C" int symbolic_demangle_swift_module_name(const char *symbol,
+                                                   size_t symbol_length,
+                                                   symbolic_swift_sink sink,
+                                                   void *sink_context) {
+    ContextGuard state;
+    std::string module = state->context.getModuleName(
+        llvm::StringRef(symbol, symbol_length));
+
+    if (module.empty()) {
+        return false;
+    }
+
+    sink(sink_context, module.data(), module.size());
+    return true;
+}
+
+/// Returns whether `symbol` is a thunk, such as a partial application
+/// forwarder, a reabstraction thunk or a protocol witness thunk.
+extern "C" int symbolic_demangle_swift_is_thunk(const char *symbol,
+                                                size_t symbol_length) {
+    ContextGuard state;
+    return state->context.isThunkSymbol(
+        llvm::StringRef(symbol, symbol_length));
+}
+
+/// Passes the mangled name of the function a thunk calls to `sink`.
+///
+/// Returns `false` if `symbol` is not a thunk, or if the target cannot be
+/// derived from the mangled name alone.
+extern "C" int symbolic_demangle_swift_thunk_target(const char *symbol,
+                                                    size_t symbol_length,
+                                                    symbolic_swift_sink sink,
+                                                    void *sink_context) {
+    ContextGuard state;
+    std::string target = state->context.getThunkTarget(
+        llvm::StringRef(symbol, symbol_length));
+
+    if (target.empty()) {
+        return false;
+    }
+
+    sink(sink_context, target.data(), target.size());
+    return true;
+}
+
+/// Returns whether the function `symbol` uses the Swift calling convention.
+extern "C" int
+symbolic_demangle_swift_has_swift_calling_convention(const char *symbol,
+                                                     size_t symbol_length) {
+    ContextGuard state;
+    return state->context.hasSwiftCallingConvention(
+        llvm::StringRef(symbol, symbol_length));
+}
+
+/// A node of a flattened demangle tree.
+///
+/// Nodes are stored in pre-order, so a node's descendants immediately follow
+/// it and end at `subtree_end`. The root node has no parent and stores
+/// `UINT32_MAX` instead.
+struct symbolic_swift_node {
+    uint64_t index;
+    uint32_t parent;
+    uint32_t subtree_end;
+    uint32_t text_offset;
+    uint32_t text_length;
+    uint16_t kind;
+    uint8_t payload;
+};
+
+enum {
+    SYMBOLIC_SWIFT_PAYLOAD_NONE = 0,
+    SYMBOLIC_SWIFT_PAYLOAD_TEXT = 1,
+    SYMBOLIC_SWIFT_PAYLOAD_INDEX = 2,
+};
+
+/// Flattens a demangle tree into caller-provided node and text buffers.
+///
+/// Writing continues past the end of either buffer without storing anything,
+/// so that the required sizes are known after a single pass.
+class TreeWriter {
+  public:
+    TreeWriter(symbolic_swift_node *nodes,
+               size_t node_capacity,
+               char *text,
+               size_t text_capacity)
+        : nodes_(nodes), node_capacity_(node_capacity), text_(text),
+          text_capacity_(text_capacity) {}
+
+    void write(swift::Demangle::NodePointer node, uint32_t parent) {
+        size_t position = node_count_++;
+
+        symbolic_swift_node flat = {};
+        flat.parent = parent;
+        flat.kind = static_cast<uint16_t>(node->getKind());
+
+        if (node->hasText()) {
+            llvm::StringRef text = node->getText();
+            flat.payload = SYMBOLIC_SWIFT_PAYLOAD_TEXT;
+            flat.text_offset = static_cast<uint32_t>(text_length_);
+            flat.text_length = static_cast<uint32_t>(text.size());
+            if (text_length_ + text.size() <= text_capacity_) {
+                memcpy(text_ + text_length_, text.data(), text.size());
+            }
+            text_length_ += text.size();
+        } else if (node->hasIndex()) {
+            flat.payload = SYMBOLIC_SWIFT_PAYLOAD_INDEX;
+            flat.index = node->getIndex();
+        }
+
+        for (swift::Demangle::NodePointer child : *node) {
+            if (child) {
+                write(child, static_cast<uint32_t>(position));
+            }
+        }
+
+        flat.subtree_end = static_cast<uint32_t>(node_count_);
+        if (position < node_capacity_) {
+            nodes_[position] = flat;
+        }
+    }
+
+    size_t node_count() const { return node_count_; }
+    size_t text_length() const { return text_length_; }
+
+  private:
+    symbolic_swift_node *nodes_;
+    size_t node_capacity_;
+    char *text_;
+    size_t text_capacity_;
+    size_t node_count_ = 0;
+    size_t text_length_ = 0;
+};
+
+/// Exports the demangle tree of `symbol` as a flat array of nodes.
+///
+/// Nodes are written to `nodes` in pre-order and the text of all nodes is
+/// concatenated into `text`, which receives no NUL terminator. The total text
+/// length is stored in `text_length`.
+///
+/// Returns the number of nodes in the tree, or `0` if the symbol cannot be
+/// demangled. If this exceeds `node_capacity`, or `text_length` exceeds
+/// `text_capacity`, the buffers are incomplete and the call must be repeated
+/// with larger buffers.
+extern "C" size_t symbolic_demangle_swift_tree(const char *symbol,
+                                               size_t symbol_length,
+                                               symbolic_swift_node *nodes,
+                                               size_t node_capacity,
+                                               char *text,
+                                               size_t text_capacity,
+                                               size_t *text_length) {
+    ContextGuard state;
+    swift::Demangle::NodePointer root = state->context.demangleSymbolAsNode(
+        llvm::StringRef(symbol, symbol_length));
+
+    *text_length = 0;
+    if (!root) {
+        return 0;
+    }
+
+    TreeWriter writer(nodes, node_capacity, text, text_capacity);
+    writer.write(root, UINT32_MAX);
+
+    *text_length = writer.text_length();
+    return writer.node_count();
+}
+
+/// Returns the name of a node kind reported by `symbolic_demangle_swift_tree`.
+extern "C" const char *symbolic_demangle_swift_node_kind(uint16_t kind) {
+    return swift::Demangle::getNodeKindString(
+        static_cast<swift::Demangle::Node::Kind>(kind));
+}
+
+/// Copies the demangler's allocation statistics, summed over all threads, into
+/// `stats`.
+extern "C" void symbolic_demangle_swift_stats(symbolic_swift_stats *stats) {
+    *stats = StatsRegistry::get().sum();
+}
+
 extern "C" int symbolic_demangle_is_swift_symbol(const char *symbol) {
     return swift::Demangle::isSwiftSymbol(symbol);
 }
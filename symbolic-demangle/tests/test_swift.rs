@@ -300,3 +300,168 @@ fn test_demangle_swift_no_args() {
         "$s11Supercharge2AXO7ElementPAAE8elements33_35EDDAA799FBB5B74D2F426690B0D99DLL3for2asSayqd__GSo28NSAccessibilityAttributeNamea_qd__mtSo7AXErrorVYKAcDRd__lFAC3AppC_AC6WindowCTgm5" => "specialized AX.Element.elements<A>",
     });
 }
+
+#[test]
+fn test_demangle_swift_long_name() {
+    use symbolic_common::{Name, NameMangling};
+    use symbolic_demangle::Demangle;
+
+    // Demangled names used to be limited to 4096 bytes and longer names silently failed.
+    let ident = "a".repeat(5000);
+    let mangled = format!("$s4main{}{}yyF", ident.len(), ident);
+    let name = Name::new(mangled.as_str(), NameMangling::Mangled, Language::Swift);
+
+    let demangled = name.demangle(DemangleOptions::complete());
+    assert_eq!(demangled, Some(format!("main.{ident}() -> ()")));
+}
+
+#[test]
+fn test_demangle_swift_batch() {
+    use symbolic_demangle::demangle_swift_batch;
+
+    let names = [
+        "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF",
+        "",
+        "_T08mangling14varargsVsArrayySi3arrd_SS1ntF",
+        "$s8mangling24InstanceAndClassPropertyV8propertySivgZ",
+    ];
+
+    let batch = demangle_swift_batch(&names, DemangleOptions::name_only().parameters(true));
+    assert_eq!(batch.len(), 4);
+    assert_eq!(
+        batch.iter().collect::<Vec<_>>(),
+        [
+            Some("GenericUnion.Foo<A>(GenericUnion<A>.Type)"),
+            None,
+            Some("varargsVsArray(arr: Int..., n: String)"),
+            Some("static InstanceAndClassProperty.property.getter"),
+        ]
+    );
+    assert_eq!(batch.get(4), None);
+
+    assert!(demangle_swift_batch::<&str>(&[], DemangleOptions::complete()).is_empty());
+}
+
+#[test]
+fn test_demangle_swift_truncated() {
+    use symbolic_common::{Name, NameMangling};
+    use symbolic_demangle::Demangle;
+
+    // Names beyond 16 KiB are cut off at a character boundary instead of being dropped.
+    let ident = "ä".repeat(10_000);
+    let mangled = format!("$s4main{}{}yyF", ident.len(), ident);
+    let name = Name::new(mangled.as_str(), NameMangling::Mangled, Language::Swift);
+
+    let demangled = name.demangle(DemangleOptions::complete()).unwrap();
+    assert_eq!(demangled.len(), 16 * 1024 - 1);
+    assert!(demangled.starts_with("main.ää"));
+    assert!(demangled.ends_with('ä'));
+}
+
+#[test]
+fn test_demangle_swift_stats() {
+    use symbolic_common::{Name, NameMangling};
+    use symbolic_demangle::{swift_demangler_stats, Demangle};
+
+    let before = swift_demangler_stats();
+
+    let name = Name::new(
+        "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF",
+        NameMangling::Mangled,
+        Language::Swift,
+    );
+    name.demangle(DemangleOptions::complete()).unwrap();
+
+    let after = swift_demangler_stats();
+    assert!(after.symbols > before.symbols);
+    assert!(after.allocated_histogram.iter().sum::<u64>() > 0);
+}
+
+#[test]
+fn test_swift_queries() {
+    use symbolic_demangle::{
+        has_swift_calling_convention, is_swift_thunk, swift_module_name, swift_thunk_target,
+    };
+
+    let function = "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF";
+    assert_eq!(swift_module_name(function).as_deref(), Some("mangling"));
+    assert_eq!(
+        swift_module_name("_T08mangling3barSiyKF").as_deref(),
+        Some("mangling")
+    );
+    assert!(!is_swift_thunk(function));
+    assert_eq!(swift_thunk_target(function), None);
+    assert!(has_swift_calling_convention(function));
+
+    // partial apply forwarder for main.foo() -> ()
+    let partial_apply = "$s4main3fooyyFTA";
+    assert!(is_swift_thunk(partial_apply));
+    assert_eq!(
+        swift_thunk_target(partial_apply).as_deref(),
+        Some("$s4main3fooyyF")
+    );
+
+    // protocol witness for main.P.foo() -> () in conformance main.S : main.P in main
+    let witness = "$s4main1SVAA1PA2aDP3fooyyFTW";
+    assert!(is_swift_thunk(witness));
+    assert_eq!(swift_thunk_target(witness), None);
+
+    // type metadata accessor for main.S
+    assert!(!has_swift_calling_convention("$s4main1SVMa"));
+
+    assert_eq!(swift_module_name("xyz"), None);
+    assert!(!is_swift_thunk("xyz"));
+    assert!(!has_swift_calling_convention("xyz"));
+}
+
+#[test]
+fn test_demangle_swift_tree() {
+    use symbolic_demangle::SwiftDemangleTree;
+
+    // mangling.GenericUnion.Foo<A>(Swift.Int) -> mangling.GenericUnion<A>
+    let tree = SwiftDemangleTree::parse("$s8mangling12GenericUnionO3FooyACyxGSicAEmlF").unwrap();
+    let root = tree.root().unwrap();
+    assert_eq!(root.kind(), "Global");
+
+    let function = root.child(0).unwrap();
+    let names: Vec<_> = function
+        .children()
+        .map(|child| (child.kind(), child.text()))
+        .collect();
+    assert_eq!(names[0].0, "Enum");
+    assert_eq!(names[1], ("Identifier", Some("Foo")));
+
+    let module = tree.iter().find(|node| node.kind() == "Module").unwrap();
+    assert_eq!(module.text(), Some("mangling"));
+    assert_eq!(module.parent().unwrap().kind(), "Enum");
+
+    assert!(SwiftDemangleTree::parse("xyz").is_none());
+}
+
+#[test]
+fn test_demangle_swift_renderings() {
+    use symbolic_common::{Name, NameMangling};
+    use symbolic_demangle::{demangle_swift_renderings, Demangle};
+
+    let options = [
+        DemangleOptions::complete(),
+        DemangleOptions::name_only().parameters(true),
+        DemangleOptions::name_only(),
+    ];
+
+    for mangled in [
+        "$s8mangling12GenericUnionO3FooyACyxGSicAEmlF",
+        "_T08mangling3barSiyKF",
+        "$s4main3fooyyFTA",
+    ] {
+        let renderings = demangle_swift_renderings(mangled, &options).unwrap();
+        assert_eq!(renderings.len(), options.len());
+
+        let name = Name::new(mangled, NameMangling::Mangled, Language::Swift);
+        for (rendering, opts) in renderings.iter().zip(options) {
+            assert_eq!(rendering.map(str::to_owned), name.demangle(opts));
+        }
+    }
+
+    assert!(demangle_swift_renderings("xyz", &options).is_none());
+}
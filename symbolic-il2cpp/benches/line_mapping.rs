@@ -0,0 +1,79 @@
+use std::collections::BTreeMap;
+
+use criterion::{criterion_group, criterion_main, Criterion};
+
+use symbolic_il2cpp::{LineMapping, LineMappingCache, LineMappingCacheConverter};
+
+const CPP_FILES: u32 = 2000;
+const CS_FILES: u32 = 100;
+const LINES_PER_FILE: u32 = 500;
+
+/// Generates a JSON line mapping of `CPP_FILES` C++ files with `LINES_PER_FILE` mapped lines each.
+fn generate_mapping() -> Vec<u8> {
+    let mut mapping = BTreeMap::new();
+    for cpp_file in 0..CPP_FILES {
+        let mut cs_files = BTreeMap::<_, BTreeMap<_, _>>::new();
+        for line in 0..LINES_PER_FILE {
+            let cs_file = format!(
+                "/Assets/Scripts/Script{}.cs",
+                (cpp_file + line / 50) % CS_FILES
+            );
+            cs_files.entry(cs_file).or_default().insert(line * 10, line);
+        }
+        mapping.insert(format!("/il2cpp/output/Assembly{cpp_file}.cpp"), cs_files);
+    }
+
+    serde_json::to_vec(&mapping).unwrap()
+}
+
+/// Returns C++ file and line pairs spread over the mapping.
+fn lookups() -> Vec<(String, u32)> {
+    (0..1000)
+        .map(|i| {
+            let file = format!("/il2cpp/output/Assembly{}.cpp", (i * 7) % CPP_FILES);
+            (file, (i * 37) % (LINES_PER_FILE * 10))
+        })
+        .collect()
+}
+
+fn line_mapping(c: &mut Criterion) {
+    let mut group = c.benchmark_group("il2cpp line mapping");
+
+    let json = generate_mapping();
+    let line_mapping = LineMapping::parse(&json).unwrap();
+
+    let mut cache = Vec::new();
+    let mut converter = LineMappingCacheConverter::new();
+    converter.process_line_mapping(&line_mapping);
+    converter.serialize(&mut cache).unwrap();
+
+    group.bench_function("load json", |b| {
+        b.iter(|| LineMapping::parse(&json).unwrap())
+    });
+    group.bench_function("load cache", |b| {
+        b.iter(|| LineMappingCache::parse(&cache).unwrap())
+    });
+
+    let lookups = lookups();
+    let cache = LineMappingCache::parse(&cache).unwrap();
+
+    group.bench_function("lookup json", |b| {
+        b.iter(|| {
+            for (file, line) in &lookups {
+                criterion::black_box(line_mapping.lookup(file, *line));
+            }
+        })
+    });
+    group.bench_function("lookup cache", |b| {
+        b.iter(|| {
+            for (file, line) in &lookups {
+                criterion::black_box(cache.lookup(file, *line));
+            }
+        })
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, line_mapping);
+criterion_main!(benches);
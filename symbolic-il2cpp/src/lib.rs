@@ -6,4 +6,7 @@
 
 mod line_mapping;
 
-pub use line_mapping::{LineMapping, ObjectLineMapping};
+pub use line_mapping::{
+    LineMapping, LineMappingCache, LineMappingCacheConverter, LineMappingCacheError,
+    ObjectLineMapping,
+};
@@ -0,0 +1,393 @@
+//! A binary, memory-mappable format for il2cpp line mappings.
+//!
+//! Parsing a JSON [`LineMapping`] allocates all of its file names and entries. A
+//! [`LineMappingCache`] instead is read directly from a buffer, such as a
+//! [`ByteView`](symbolic_common::ByteView), and only validates its header on parse.
+//!
+//! # Structure of a LineMappingCache
+//!
+//! A LineMappingCache (version 1) contains the following data, written in the following order:
+//!
+//! 1. A [`Header`](raw::Header)
+//! 2. C++ Files, sorted by name
+//! 3. Line Entries, grouped by C++ file and sorted by C++ line
+//! 4. String Data
+//!
+//! Every section is aligned to 8 bytes. Strings are saved in one contiguous section with each
+//! individual string prefixed by its length in LEB-128 encoding. Files and entries refer to strings
+//! by an offset into this string section.
+//!
+//! # Lookups
+//!
+//! To look up a C++ file and line:
+//!
+//! 1. Find the C++ file via binary search over the file names.
+//! 2. Find the last line entry of that file at or before the line via binary search.
+//! 3. Read the C# file name of that entry from the string section.
+
+use std::collections::BTreeMap;
+use std::io::Write;
+
+use symbolic_common::{AsSelf, DebugId};
+use thiserror::Error;
+use watto::{align_to, Pod, StringTable};
+
+use super::{find_entry, raw, LineMapping, ObjectLineMapping};
+
+/// The latest version of the LineMappingCache format.
+const LINE_MAPPING_CACHE_VERSION: u32 = 1;
+
+/// An error encountered while parsing a [`LineMappingCache`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Error)]
+#[non_exhaustive]
+pub enum LineMappingCacheError {
+    /// The cache header could not be read.
+    #[error("could not read header")]
+    InvalidHeader,
+    /// The cache file's endianness does not match the system's endianness.
+    #[error("wrong endianness")]
+    WrongEndianness,
+    /// The cache file header does not contain the correct magic bytes.
+    #[error("invalid magic: {0}")]
+    InvalidMagic(u32),
+    /// The cache file header contains an invalid version.
+    #[error("wrong version: {0}")]
+    WrongVersion(u32),
+    /// File data could not be parsed from the cache file.
+    #[error("could not read files")]
+    InvalidFiles,
+    /// Line entry data could not be parsed from the cache file.
+    #[error("could not read line entries")]
+    InvalidEntries,
+    /// The header claimed an incorrect number of string bytes.
+    #[error("expected {expected} string bytes, found {found}")]
+    UnexpectedStringBytes {
+        /// Expected number of string bytes.
+        expected: usize,
+        /// Number of string bytes actually found in the cache file.
+        found: usize,
+    },
+}
+
+/// A binary il2cpp line mapping that can be read without deserializing it.
+///
+/// This can be parsed from a binary buffer via [`LineMappingCache::parse`], and provides the same
+/// lookups as [`LineMapping::lookup`]. To create one, use a [`LineMappingCacheConverter`].
+#[derive(Clone, PartialEq, Eq)]
+pub struct LineMappingCache<'data> {
+    header: &'data raw::Header,
+    files: &'data [raw::File],
+    entries: &'data [raw::LineEntry],
+    string_bytes: &'data [u8],
+}
+
+impl<'data> LineMappingCache<'data> {
+    /// Parses the given buffer into a `LineMappingCache`.
+    pub fn parse(buf: &'data [u8]) -> Result<Self, LineMappingCacheError> {
+        let (header, rest) =
+            raw::Header::ref_from_prefix(buf).ok_or(LineMappingCacheError::InvalidHeader)?;
+
+        if header.magic == raw::LINE_MAPPING_CACHE_MAGIC_FLIPPED {
+            return Err(LineMappingCacheError::WrongEndianness);
+        }
+        if header.magic != raw::LINE_MAPPING_CACHE_MAGIC {
+            return Err(LineMappingCacheError::InvalidMagic(header.magic));
+        }
+
+        if header.version != LINE_MAPPING_CACHE_VERSION {
+            return Err(LineMappingCacheError::WrongVersion(header.version));
+        }
+
+        let (_, rest) = align_to(rest, 8).ok_or(LineMappingCacheError::InvalidFiles)?;
+
+        let (files, rest) = raw::File::slice_from_prefix(rest, header.num_files as usize)
+            .ok_or(LineMappingCacheError::InvalidFiles)?;
+
+        let (_, rest) = align_to(rest, 8).ok_or(LineMappingCacheError::InvalidEntries)?;
+
+        let (entries, rest) = raw::LineEntry::slice_from_prefix(rest, header.num_entries as usize)
+            .ok_or(LineMappingCacheError::InvalidEntries)?;
+
+        let (_, rest) = align_to(rest, 8).ok_or(LineMappingCacheError::UnexpectedStringBytes {
+            expected: header.string_bytes as usize,
+            found: 0,
+        })?;
+
+        if rest.len() < header.string_bytes as usize {
+            return Err(LineMappingCacheError::UnexpectedStringBytes {
+                expected: header.string_bytes as usize,
+                found: rest.len(),
+            });
+        }
+
+        Ok(Self {
+            header,
+            files,
+            entries,
+            string_bytes: rest,
+        })
+    }
+
+    /// Returns the [`DebugId`] of the object file this mapping was created from.
+    ///
+    /// This is nil if the mapping was converted from JSON without a debug id.
+    pub fn debug_id(&self) -> DebugId {
+        self.header.debug_id
+    }
+
+    /// Looks up the corresponding C# file/line for a given C++ file/line.
+    ///
+    /// This behaves exactly like [`LineMapping::lookup`].
+    pub fn lookup(&self, file: &str, line: u32) -> Option<(&'data str, u32)> {
+        let file_idx = self
+            .files
+            .binary_search_by(|f| self.get_string(f.name_offset).unwrap_or_default().cmp(file))
+            .ok()?;
+
+        let file = &self.files[file_idx];
+        let start = file.first_entry as usize;
+        let end = start.checked_add(file.num_entries as usize)?;
+        let entries = self.entries.get(start..end)?;
+
+        let entry = find_entry(entries, line, |entry| entry.cpp_line)?;
+        Some((self.get_string(entry.cs_file_offset)?, entry.cs_line))
+    }
+
+    fn get_string(&self, offset: u32) -> Option<&'data str> {
+        StringTable::read(self.string_bytes, offset as usize).ok()
+    }
+}
+
+impl std::fmt::Debug for LineMappingCache<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("LineMappingCache")
+            .field("version", &self.header.version)
+            .field("debug_id", &self.debug_id())
+            .field("files", &self.header.num_files)
+            .field("entries", &self.header.num_entries)
+            .field("string_bytes", &self.header.string_bytes)
+            .finish()
+    }
+}
+
+impl<'slf, 'd: 'slf> AsSelf<'slf> for LineMappingCache<'d> {
+    type Ref = LineMappingCache<'slf>;
+
+    fn as_self(&'slf self) -> &'slf Self::Ref {
+        self
+    }
+}
+
+/// The LineMappingCache Converter.
+///
+/// This converts a parsed JSON [`LineMapping`] or an [`ObjectLineMapping`] and serializes it
+/// via its [`serialize`](LineMappingCacheConverter::serialize) method.
+#[derive(Debug, Default)]
+pub struct LineMappingCacheConverter {
+    debug_id: DebugId,
+    /// A map of C++ file name to its line entries, sorted by C++ line.
+    files: BTreeMap<String, Vec<raw::LineEntry>>,
+    string_table: StringTable,
+}
+
+impl LineMappingCacheConverter {
+    /// Creates a new Converter.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Processes a parsed JSON line mapping.
+    ///
+    /// Mappings of C++ files that have been processed before are replaced.
+    pub fn process_line_mapping(&mut self, mapping: &LineMapping) {
+        if !mapping.debug_id.is_nil() {
+            self.debug_id = mapping.debug_id;
+        }
+
+        for (cpp_file, lines) in &mapping.cpp_file_map {
+            let entries = lines
+                .iter()
+                .map(|entry| raw::LineEntry {
+                    cpp_line: entry.cpp_line,
+                    cs_line: entry.cs_line,
+                    cs_file_offset: mapping
+                        .cs_files
+                        .get_index(entry.cs_file_idx)
+                        .map_or(u32::MAX, |cs_file| self.string_table.insert(cs_file) as u32),
+                })
+                .collect();
+
+            self.files.insert(cpp_file.clone(), entries);
+        }
+    }
+
+    /// Processes a line mapping extracted from an object.
+    ///
+    /// This is equivalent to serializing the mapping to JSON with
+    /// [`ObjectLineMapping::to_writer`], parsing it and calling
+    /// [`process_line_mapping`](Self::process_line_mapping).
+    pub fn process_object_line_mapping(&mut self, mapping: &ObjectLineMapping) {
+        self.debug_id = mapping.debug_id;
+
+        for (cpp_file, cs_files) in &mapping.mapping {
+            let mut entries = Vec::new();
+            for (cs_file, lines) in cs_files {
+                let cs_file_offset = self.string_table.insert(cs_file) as u32;
+                entries.extend(lines.iter().map(|(&cpp_line, &cs_line)| raw::LineEntry {
+                    cpp_line,
+                    cs_line,
+                    cs_file_offset,
+                }));
+            }
+
+            // This is a stable sort, just like the one in `LineMapping::parse`.
+            entries.sort_by_key(|entry| entry.cpp_line);
+            self.files.insert(cpp_file.clone(), entries);
+        }
+    }
+
+    /// Serialize the converted data.
+    ///
+    /// This writes the LineMappingCache binary format into the given [`Write`].
+    pub fn serialize<W: Write>(mut self, writer: &mut W) -> std::io::Result<()> {
+        let mut writer = watto::Writer::new(writer);
+
+        let mut num_entries = 0;
+        let files: Vec<_> = self
+            .files
+            .iter()
+            .map(|(name, entries)| {
+                let file = raw::File {
+                    name_offset: self.string_table.insert(name) as u32,
+                    first_entry: num_entries,
+                    num_entries: entries.len() as u32,
+                };
+                num_entries += file.num_entries;
+                file
+            })
+            .collect();
+
+        let string_bytes = self.string_table.into_bytes();
+
+        let header = raw::Header {
+            magic: raw::LINE_MAPPING_CACHE_MAGIC,
+            version: LINE_MAPPING_CACHE_VERSION,
+
+            debug_id: self.debug_id,
+
+            num_files: files.len() as u32,
+            num_entries,
+            string_bytes: string_bytes.len() as u32,
+            _reserved: [0; 16],
+        };
+
+        writer.write_all(header.as_bytes())?;
+        writer.align_to(8)?;
+
+        for file in &files {
+            writer.write_all(file.as_bytes())?;
+        }
+        writer.align_to(8)?;
+
+        for entry in self.files.values().flatten() {
+            writer.write_all(entry.as_bytes())?;
+        }
+        writer.align_to(8)?;
+
+        writer.write_all(&string_bytes)?;
+
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::collections::HashMap;
+
+    use super::*;
+
+    const CPP_SOURCE: &[u8] = b"Lorem ipsum dolor sit amet
+        //<source_info:main.cs:17>
+        // some
+        // comments
+        some expression // 5
+        //<source_info:other.cs:3>
+        more code
+
+        //<source_info:main.cs:29>
+        actual source code // 10
+    ";
+
+    fn object_line_mapping() -> ObjectLineMapping {
+        let mapping = ObjectLineMapping::parse_source_file(CPP_SOURCE);
+        ObjectLineMapping {
+            mapping: BTreeMap::from([
+                ("main.cpp".to_owned(), mapping.clone()),
+                ("other.cpp".to_owned(), mapping),
+            ]),
+            debug_id: "5b65abfb-2338-4f0b-b3b9-64c8f734d43f".parse().unwrap(),
+        }
+    }
+
+    #[test]
+    fn test_lookup_matches_line_mapping() {
+        let object_mapping = object_line_mapping();
+
+        let mut json = Vec::new();
+        ObjectLineMapping {
+            mapping: object_mapping.mapping.clone(),
+            debug_id: object_mapping.debug_id,
+        }
+        .to_writer(&mut json)
+        .unwrap();
+        let line_mapping = LineMapping::parse(&json).unwrap();
+
+        let mut from_object = Vec::new();
+        let mut converter = LineMappingCacheConverter::new();
+        converter.process_object_line_mapping(&object_mapping);
+        converter.serialize(&mut from_object).unwrap();
+
+        let mut from_json = Vec::new();
+        let mut converter = LineMappingCacheConverter::new();
+        converter.process_line_mapping(&line_mapping);
+        converter.serialize(&mut from_json).unwrap();
+
+        for buf in [&from_object, &from_json] {
+            let cache = LineMappingCache::parse(buf).unwrap();
+            assert_eq!(cache.debug_id(), object_mapping.debug_id);
+
+            for file in ["main.cpp", "other.cpp", "missing.cpp", ""] {
+                for line in 0..100 {
+                    assert_eq!(cache.lookup(file, line), line_mapping.lookup(file, line));
+                }
+            }
+            assert_eq!(cache.lookup("main.cpp", 7), Some(("other.cs", 3)));
+        }
+    }
+
+    #[test]
+    fn test_parse_errors() {
+        let mapping = HashMap::from([("main.cpp", ObjectLineMapping::parse_source_file(b""))]);
+        let json = serde_json::to_vec(&mapping).unwrap();
+
+        let mut buf = Vec::new();
+        let mut converter = LineMappingCacheConverter::new();
+        converter.process_line_mapping(&LineMapping::parse(&json).unwrap());
+        converter.serialize(&mut buf).unwrap();
+
+        let cache = LineMappingCache::parse(&buf).unwrap();
+        assert_eq!(cache.debug_id(), DebugId::nil());
+        assert_eq!(cache.lookup("main.cpp", 1), None);
+
+        assert_eq!(
+            LineMappingCache::parse(&buf[..10]),
+            Err(LineMappingCacheError::InvalidHeader)
+        );
+
+        buf[4] = 2;
+        assert_eq!(
+            LineMappingCache::parse(&buf),
+            Err(LineMappingCacheError::WrongVersion(2))
+        );
+    }
+}
@@ -9,10 +9,12 @@ use symbolic_debuginfo::{DebugSession, ObjectLike};
 /// A line mapping extracted from an object.
 ///
 /// This is only intended as an intermediate structure for serialization,
-/// not for lookups.
+/// not for lookups. It can be serialized to JSON with [`to_writer`](Self::to_writer), or into a
+/// binary [`LineMappingCache`](crate::LineMappingCache) with a
+/// [`LineMappingCacheConverter`](crate::LineMappingCacheConverter).
 pub struct ObjectLineMapping {
-    mapping: BTreeMap<String, BTreeMap<String, BTreeMap<u32, u32>>>,
-    debug_id: DebugId,
+    pub(crate) mapping: BTreeMap<String, BTreeMap<String, BTreeMap<u32, u32>>>,
+    pub(crate) debug_id: DebugId,
 }
 
 impl ObjectLineMapping {
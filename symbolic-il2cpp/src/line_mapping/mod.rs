@@ -1,10 +1,18 @@
+mod cache;
 mod from_object;
+mod raw;
 
 use indexmap::IndexSet;
 use std::collections::HashMap;
 
+use symbolic_common::DebugId;
+
+pub use cache::{LineMappingCache, LineMappingCacheConverter, LineMappingCacheError};
 pub use from_object::ObjectLineMapping;
 
+/// Mappings are only applied to lines at most this many lines after the line they refer to.
+const MAX_LINE_DISTANCE: u32 = 50;
+
 /// An internal line mapping.
 #[derive(Debug)]
 struct LineEntry {
@@ -19,6 +27,8 @@ struct LineEntry {
 /// A parsed Il2Cpp/Unity Line mapping JSON.
 #[derive(Debug, Default)]
 pub struct LineMapping {
+    /// The debug id of the originating object file, if the mapping contains one.
+    debug_id: DebugId,
     /// The set of C# files.
     cs_files: IndexSet<String>,
     /// A map of C++ filename to a list of Mappings.
@@ -39,6 +49,13 @@ impl LineMapping {
                 // `ObjectLineMapping::to_writer` writes to the file to make it unique
                 // (and dependent on the originating debug-id).
                 if cpp_file == "__debug-id__" {
+                    if let serde_json::Value::Object(debug_id) = file_map {
+                        result.debug_id = debug_id
+                            .keys()
+                            .next()
+                            .and_then(|id| id.parse().ok())
+                            .unwrap_or_default();
+                    }
                     continue;
                 }
                 let mut lines = Vec::new();
@@ -71,21 +88,26 @@ impl LineMapping {
     /// As these mappings are not exact, this will return an exact match, or a mapping "close-by".
     pub fn lookup(&self, file: &str, line: u32) -> Option<(&str, u32)> {
         let lines = self.cpp_file_map.get(file)?;
+        let entry = find_entry(lines, line, |entry| entry.cpp_line)?;
+        Some((self.cs_files.get_index(entry.cs_file_idx)?, entry.cs_line))
+    }
+}
 
-        let idx = match lines.binary_search_by_key(&line, |entry| entry.cpp_line) {
-            Ok(idx) => idx,
-            Err(0) => return None,
-            Err(idx) => idx - 1,
-        };
+/// Finds the entry that maps the given C++ line in a list of entries sorted by C++ line.
+fn find_entry<T>(entries: &[T], line: u32, cpp_line: impl Fn(&T) -> u32) -> Option<&T> {
+    let idx = match entries.binary_search_by_key(&line, &cpp_line) {
+        Ok(idx) => idx,
+        Err(0) => return None,
+        Err(idx) => idx - 1,
+    };
 
-        let entry = lines.get(idx)?;
+    let entry = entries.get(idx)?;
 
-        // We will return mappings at most 50 lines away from the source line they refer to.
-        if line.saturating_sub(entry.cpp_line) > 50 {
-            None
-        } else {
-            Some((self.cs_files.get_index(entry.cs_file_idx)?, entry.cs_line))
-        }
+    // We will return mappings at most 50 lines away from the source line they refer to.
+    if line.saturating_sub(cpp_line(entry)) > MAX_LINE_DISTANCE {
+        None
+    } else {
+        Some(entry)
     }
 }
 
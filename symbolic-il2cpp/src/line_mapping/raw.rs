@@ -0,0 +1,84 @@
+use symbolic_common::DebugId;
+use watto::Pod;
+
+/// The magic file preamble as individual bytes.
+const LINE_MAPPING_CACHE_MAGIC_BYTES: [u8; 4] = *b"ILMC";
+
+/// The magic file preamble to identify LineMappingCache files.
+///
+/// Serialized as ASCII "ILMC" on little-endian (x64) systems.
+pub(crate) const LINE_MAPPING_CACHE_MAGIC: u32 = u32::from_le_bytes(LINE_MAPPING_CACHE_MAGIC_BYTES);
+/// The byte-flipped magic, which indicates an endianness mismatch.
+pub(crate) const LINE_MAPPING_CACHE_MAGIC_FLIPPED: u32 = LINE_MAPPING_CACHE_MAGIC.swap_bytes();
+
+/// The header of a LineMappingCache file.
+#[derive(Debug, Clone, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct Header {
+    /// The file magic representing the file format and endianness.
+    pub(crate) magic: u32,
+    /// The LineMappingCache format version.
+    pub(crate) version: u32,
+    /// The debug id of the object file the mapping was created from.
+    pub(crate) debug_id: DebugId,
+    /// The number of C++ files contained in the cache file.
+    pub(crate) num_files: u32,
+    /// The number of line entries contained in the cache file.
+    pub(crate) num_entries: u32,
+    /// Total number of bytes used for string data.
+    pub(crate) string_bytes: u32,
+    /// Some reserved space in the header for future extensions that would not require a
+    /// completely new parsing method.
+    pub(crate) _reserved: [u8; 16],
+}
+
+/// A C++ file and the range of its line entries.
+///
+/// Files are sorted by their name.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct File {
+    /// The C++ file path (reference to a [`String`]).
+    pub(crate) name_offset: u32,
+    /// The index of the first [`LineEntry`] of this file.
+    pub(crate) first_entry: u32,
+    /// The number of [`LineEntry`]s of this file.
+    pub(crate) num_entries: u32,
+}
+
+/// A mapping from a C++ line to a C# file and line.
+///
+/// The entries of a file are sorted by their C++ line.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct LineEntry {
+    /// The C++ line that is being mapped.
+    pub(crate) cpp_line: u32,
+    /// The C# line it corresponds to.
+    pub(crate) cs_line: u32,
+    /// The C# file path (reference to a [`String`]).
+    pub(crate) cs_file_offset: u32,
+}
+
+unsafe impl Pod for Header {}
+unsafe impl Pod for File {}
+unsafe impl Pod for LineEntry {}
+
+#[cfg(test)]
+mod tests {
+    use std::mem;
+
+    use super::*;
+
+    #[test]
+    fn test_sizeof() {
+        assert_eq!(mem::size_of::<Header>(), 68);
+        assert_eq!(mem::align_of::<Header>(), 4);
+
+        assert_eq!(mem::size_of::<File>(), 12);
+        assert_eq!(mem::align_of::<File>(), 4);
+
+        assert_eq!(mem::size_of::<LineEntry>(), 12);
+        assert_eq!(mem::align_of::<LineEntry>(), 4);
+    }
+}
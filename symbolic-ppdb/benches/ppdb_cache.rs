@@ -0,0 +1,145 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use symbolic_common::{ByteView, DebugId};
+use symbolic_ppdb::{
+    CacheError, PortablePdb, PortablePdbCache, PortablePdbCacheConverter, PortablePdbCacheMap,
+};
+use symbolic_testutils::{fixture, Rng};
+
+/// The fixtures to convert and look up in.
+const FIXTURES: &[&str] = &[
+    "windows/portable.pdb",
+    "windows/Sentry.Samples.Console.Basic.pdb",
+];
+
+/// The number of frames in every batch.
+const BATCH_SIZE: usize = 10_000;
+
+fn convert(pdb: &PortablePdb<'_>) -> Vec<u8> {
+    let mut converter = PortablePdbCacheConverter::new();
+    converter.process_portable_pdb(pdb).unwrap();
+    let mut buf = Vec::new();
+    converter.serialize(&mut buf).unwrap();
+    buf
+}
+
+/// Creates a batch of `(func_idx, il_offset)` frames, concentrated on a few hot methods as in
+/// stack traces of many threads.
+fn frames() -> Vec<(u32, u32)> {
+    let mut rng = Rng::new();
+    let hot_methods: Vec<u32> = (0..16).map(|_| 1 + (rng.next_u64() % 64) as u32).collect();
+
+    (0..BATCH_SIZE)
+        .map(|_| {
+            let func_idx = hot_methods[rng.next_u64() as usize % hot_methods.len()];
+            (func_idx, (rng.next_u64() % 0x100) as u32)
+        })
+        .collect()
+}
+
+fn bench_conversion(c: &mut Criterion) {
+    let mut group = c.benchmark_group("conversion");
+
+    for path in FIXTURES {
+        let buf = std::fs::read(fixture(path)).unwrap();
+        let pdb = PortablePdb::parse(&buf).unwrap();
+
+        group.bench_with_input(BenchmarkId::new("convert", path), &pdb, |b, pdb| {
+            b.iter(|| convert(pdb))
+        });
+    }
+
+    group.finish();
+}
+
+fn bench_lookup(c: &mut Criterion) {
+    let mut group = c.benchmark_group("lookup");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+
+    let frames = frames();
+    let mut sorted = frames.clone();
+    sorted.sort_unstable();
+
+    for path in FIXTURES {
+        let buf = std::fs::read(fixture(path)).unwrap();
+        let data = convert(&PortablePdb::parse(&buf).unwrap());
+        let cache = PortablePdbCache::parse(&data).unwrap();
+
+        for (label, frames) in [("clustered", &frames), ("sorted", &sorted)] {
+            let id = format!("{path}/{label}");
+
+            group.bench_with_input(BenchmarkId::new("lookup", &id), frames, |b, frames| {
+                b.iter(|| {
+                    for &(func_idx, il_offset) in frames {
+                        criterion::black_box(cache.lookup(func_idx, il_offset));
+                    }
+                })
+            });
+
+            group.bench_with_input(BenchmarkId::new("lookup_many", &id), frames, |b, frames| {
+                b.iter(|| {
+                    for item in cache.lookup_many(frames) {
+                        criterion::black_box(item);
+                    }
+                })
+            });
+        }
+    }
+
+    group.finish();
+}
+
+/// Resolves a frame per event across `threads` threads, either parsing the cache for every event
+/// or fetching it from a shared map.
+fn bench_cache_map(c: &mut Criterion) {
+    let mut group = c.benchmark_group("cache map");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+
+    let buf = std::fs::read(fixture("windows/portable.pdb")).unwrap();
+    let pdb = PortablePdb::parse(&buf).unwrap();
+    let debug_id: DebugId = pdb.pdb_id().unwrap();
+    let data = ByteView::from_vec(convert(&pdb));
+    let frames = frames();
+
+    for threads in [1, 4] {
+        let chunk_size = frames.len().div_ceil(threads);
+
+        group.bench_with_input(BenchmarkId::new("parse", threads), &threads, |b, _| {
+            b.iter(|| {
+                std::thread::scope(|s| {
+                    for chunk in frames.chunks(chunk_size) {
+                        s.spawn(|| {
+                            for &(func_idx, il_offset) in chunk {
+                                let cache = PortablePdbCache::parse(&data).unwrap();
+                                criterion::black_box(cache.lookup(func_idx, il_offset));
+                            }
+                        });
+                    }
+                })
+            })
+        });
+
+        let map = PortablePdbCacheMap::new(64 << 20);
+        group.bench_with_input(BenchmarkId::new("shared", threads), &threads, |b, _| {
+            b.iter(|| {
+                std::thread::scope(|s| {
+                    for chunk in frames.chunks(chunk_size) {
+                        s.spawn(|| {
+                            for &(func_idx, il_offset) in chunk {
+                                let cache = map
+                                    .get_or_load(debug_id, || Ok::<_, CacheError>(data.clone()))
+                                    .unwrap();
+                                criterion::black_box(cache.get().lookup(func_idx, il_offset));
+                            }
+                        });
+                    }
+                })
+            })
+        });
+    }
+
+    group.finish();
+}
+
+criterion_group!(benches, bench_conversion, bench_lookup, bench_cache_map);
+criterion_main!(benches);
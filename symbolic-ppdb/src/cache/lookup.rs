@@ -31,8 +31,8 @@ impl<'data> PortablePdbCache<'data> {
             func_idx,
             il_offset,
         };
-        let sl = match self.ranges.binary_search(&range) {
-            Ok(idx) => self.source_locations.get(idx)?,
+        let idx = match self.ranges.binary_search(&range) {
+            Ok(idx) => idx,
             Err(idx) => {
                 let idx = idx.checked_sub(1)?;
                 let range = self.ranges.get(idx)?;
@@ -40,10 +40,47 @@ impl<'data> PortablePdbCache<'data> {
                     return None;
                 }
 
-                self.source_locations.get(idx)?
+                idx
             }
         };
 
+        self.line_info_at(idx)
+    }
+
+    /// Looks up line information for many `(func_idx, il_offset)` pairs at once.
+    ///
+    /// See [`lookup`](Self::lookup) for the meaning of `func_idx` and `il_offset`. Frames are
+    /// grouped by function, and the frames of each function are resolved in a single pass over
+    /// its ranges. This is faster than calling [`lookup`](Self::lookup) for each frame, especially
+    /// for stack traces that hit the same functions repeatedly.
+    ///
+    /// Each [`LineInfo`] comes with the index of its frame in `frames`, so callers can map results
+    /// back to their stack trace. Results are sorted by `(func_idx, il_offset)`, and frames that
+    /// are already in that order are resolved without allocating.
+    pub fn lookup_many<'a>(&'a self, frames: &'a [(u32, u32)]) -> LookupMany<'data, 'a> {
+        let order = if frames.is_sorted() {
+            None
+        } else {
+            let mut order: Vec<usize> = (0..frames.len()).collect();
+            order.sort_unstable_by_key(|&idx| (frames[idx], idx));
+            Some(order)
+        };
+
+        LookupMany {
+            cache: self,
+            frames,
+            order,
+            position: 0,
+            function: None,
+            function_start: 0,
+            function_end: 0,
+            cursor: 0,
+        }
+    }
+
+    /// Resolves the line information of the range at `idx`.
+    fn line_info_at(&self, idx: usize) -> Option<LineInfo<'data>> {
+        let sl = self.source_locations.get(idx)?;
         let (file_name, file_lang) = self.get_file(sl.file_idx)?;
 
         Some(LineInfo {
@@ -65,3 +102,69 @@ impl<'data> PortablePdbCache<'data> {
         watto::StringTable::read(self.string_bytes, offset as usize).ok()
     }
 }
+
+/// Iterator returned by [`PortablePdbCache::lookup_many`]; see documentation there.
+#[derive(Debug, Clone)]
+pub struct LookupMany<'data, 'cache> {
+    cache: &'cache PortablePdbCache<'data>,
+    frames: &'cache [(u32, u32)],
+    /// Indexes into `frames` in ascending order, or `None` if `frames` is sorted.
+    order: Option<Vec<usize>>,
+    /// The next position in `order`.
+    position: usize,
+    /// The function of the previous frame.
+    function: Option<u32>,
+    /// The ranges of the previous function, as `function_start..function_end`.
+    function_start: usize,
+    function_end: usize,
+    /// The number of ranges at or before the previous frame.
+    cursor: usize,
+}
+
+impl<'data> Iterator for LookupMany<'data, '_> {
+    type Item = (usize, Option<LineInfo<'data>>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let idx = match self.order {
+            Some(ref order) => *order.get(self.position)?,
+            None if self.position < self.frames.len() => self.position,
+            None => return None,
+        };
+        self.position += 1;
+
+        let (func_idx, il_offset) = self.frames[idx];
+        let ranges = self.cache.ranges;
+
+        // Frames arrive in ascending order, so the ranges of a new function start after those of
+        // the previous one.
+        if self.function != Some(func_idx) {
+            let rest = &ranges[self.function_end..];
+            self.function_start =
+                self.function_end + rest.partition_point(|r| r.func_idx < func_idx);
+
+            let rest = &ranges[self.function_start..];
+            self.function_end =
+                self.function_start + rest.partition_point(|r| r.func_idx == func_idx);
+            self.function = Some(func_idx);
+            self.cursor = self.function_start;
+        }
+
+        let rest = &ranges[self.cursor..self.function_end];
+        self.cursor += rest.partition_point(|r| r.il_offset <= il_offset);
+
+        // The frame is not covered if it lies before the first range of its function.
+        let info = match self.cursor {
+            cursor if cursor == self.function_start => None,
+            cursor => self.cache.line_info_at(cursor - 1),
+        };
+
+        Some((idx, info))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let len = self.frames.len() - self.position;
+        (len, Some(len))
+    }
+}
+
+impl ExactSizeIterator for LookupMany<'_, '_> {}
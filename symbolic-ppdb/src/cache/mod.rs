@@ -49,6 +49,7 @@
 
 pub(crate) mod lookup;
 pub(crate) mod raw;
+pub(crate) mod shared;
 pub(crate) mod writer;
 
 use symbolic_common::{AsSelf, DebugId};
@@ -0,0 +1,125 @@
+//! A bounded, sharded map of parsed PortablePdbCaches.
+
+use std::sync::Arc;
+
+use symbolic_common::{ByteView, DebugId, SelfCell, ShardedCache, ShardedCacheStats};
+
+use super::{CacheError, PortablePdbCache};
+
+/// Approximate bookkeeping overhead of a cache entry in bytes, in addition to its buffer.
+const ENTRY_OVERHEAD: usize = 128;
+
+/// A [`PortablePdbCache`] that owns the buffer it was parsed from.
+pub type OwnedPortablePdbCache = SelfCell<ByteView<'static>, PortablePdbCache<'static>>;
+
+/// Statistics of a [`PortablePdbCacheMap`].
+///
+/// `bytes` is the approximate size of all cached buffers.
+pub type PortablePdbCacheMapStats = ShardedCacheStats;
+
+/// A bounded, concurrent map of parsed [`PortablePdbCache`]s, keyed by their [`DebugId`].
+///
+/// Symbolication workers resolve frames of the same few assemblies over and over. Sharing one map
+/// between all threads avoids reading and parsing their caches again for every event. The map is
+/// split into independently locked shards and evicts caches once it exceeds its size budget,
+/// preferring caches that have not been used recently. Caches are handed out as [`Arc`]s, so
+/// evicted caches stay valid for as long as they are in use.
+///
+/// # Examples
+///
+/// ```
+/// use symbolic_common::ByteView;
+/// use symbolic_ppdb::{CacheError, PortablePdb, PortablePdbCacheConverter, PortablePdbCacheMap};
+///
+/// # fn main() -> Result<(), CacheError> {
+/// # let buf = std::fs::read("../symbolic-testutils/fixtures/windows/portable.pdb").unwrap();
+/// let pdb = PortablePdb::parse(&buf)?;
+/// let mut converter = PortablePdbCacheConverter::new();
+/// converter.process_portable_pdb(&pdb)?;
+/// let mut data = Vec::new();
+/// converter.serialize(&mut data).unwrap();
+///
+/// let map = PortablePdbCacheMap::new(64 * 1024 * 1024);
+/// let debug_id = pdb.pdb_id().unwrap();
+/// let cache = map.get_or_load(debug_id, || Ok::<_, CacheError>(ByteView::from_vec(data)))?;
+/// assert_eq!(cache.get().debug_id(), debug_id);
+/// assert!(map.get(debug_id).is_some());
+/// # Ok(())
+/// # }
+/// ```
+#[derive(Debug)]
+pub struct PortablePdbCacheMap {
+    caches: ShardedCache<DebugId, Arc<OwnedPortablePdbCache>>,
+}
+
+impl PortablePdbCacheMap {
+    /// Creates a new map that holds approximately `budget` bytes of caches.
+    pub fn new(budget: usize) -> Self {
+        Self {
+            caches: ShardedCache::new(budget),
+        }
+    }
+
+    /// Returns the cache for `debug_id`, if it is in the map.
+    pub fn get(&self, debug_id: DebugId) -> Option<Arc<OwnedPortablePdbCache>> {
+        self.caches.get(&debug_id)
+    }
+
+    /// Returns the cache for `debug_id`, loading and parsing it with `load` if it is not in the
+    /// map yet.
+    ///
+    /// The cache is inserted under `debug_id`, regardless of the debug id stored in the cache.
+    /// `load` is called without holding a lock, so concurrent misses for the same debug id may
+    /// load the cache more than once.
+    pub fn get_or_load<F, E>(
+        &self,
+        debug_id: DebugId,
+        load: F,
+    ) -> Result<Arc<OwnedPortablePdbCache>, E>
+    where
+        F: FnOnce() -> Result<ByteView<'static>, E>,
+        E: From<CacheError>,
+    {
+        if let Some(cache) = self.get(debug_id) {
+            return Ok(cache);
+        }
+
+        let cache = SelfCell::try_new(load()?, |data| PortablePdbCache::parse(unsafe { &*data }))?;
+        Ok(self.insert_cell(debug_id, cache))
+    }
+
+    /// Parses a cache and inserts it under its own debug id, replacing any previous cache.
+    pub fn insert(
+        &self,
+        data: ByteView<'static>,
+    ) -> Result<Arc<OwnedPortablePdbCache>, CacheError> {
+        let cache = SelfCell::try_new(data, |data| PortablePdbCache::parse(unsafe { &*data }))?;
+        Ok(self.insert_cell(cache.get().debug_id(), cache))
+    }
+
+    fn insert_cell(
+        &self,
+        debug_id: DebugId,
+        cache: OwnedPortablePdbCache,
+    ) -> Arc<OwnedPortablePdbCache> {
+        let size = cache.owner().len() + ENTRY_OVERHEAD;
+        let cache = Arc::new(cache);
+        self.caches.insert(debug_id, Arc::clone(&cache), size);
+        cache
+    }
+
+    /// Removes the cache for `debug_id` from the map.
+    pub fn remove(&self, debug_id: DebugId) -> Option<Arc<OwnedPortablePdbCache>> {
+        self.caches.remove(&debug_id)
+    }
+
+    /// Returns hit, miss and eviction counters, as well as the current size of the map.
+    pub fn stats(&self) -> PortablePdbCacheMapStats {
+        self.caches.stats()
+    }
+
+    /// Removes all caches from the map, keeping the counters.
+    pub fn clear(&self) {
+        self.caches.clear();
+    }
+}
@@ -57,7 +57,8 @@
 mod cache;
 mod format;
 
-pub use cache::lookup::LineInfo;
+pub use cache::lookup::{LineInfo, LookupMany};
+pub use cache::shared::{OwnedPortablePdbCache, PortablePdbCacheMap, PortablePdbCacheMapStats};
 pub use cache::writer::PortablePdbCacheConverter;
 pub use cache::{CacheError, CacheErrorKind, PortablePdbCache};
 pub use format::{Document, EmbeddedSource, FormatError, FormatErrorKind, PortablePdb};
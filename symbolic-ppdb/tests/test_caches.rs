@@ -1,8 +1,12 @@
-use symbolic_common::Language;
+use std::sync::Arc;
+
+use symbolic_common::{ByteView, DebugId, Language};
+use symbolic_ppdb::CacheError;
 use symbolic_ppdb::LineInfo;
 use symbolic_ppdb::PortablePdb;
 use symbolic_ppdb::PortablePdbCache;
 use symbolic_ppdb::PortablePdbCacheConverter;
+use symbolic_ppdb::PortablePdbCacheMap;
 use symbolic_testutils::fixture;
 
 #[test]
@@ -91,3 +95,110 @@ fn test_integration() {
         })
     );
 }
+
+#[test]
+fn test_lookup_many() {
+    let buf = std::fs::read(fixture("windows/portable.pdb")).unwrap();
+
+    let pdb = PortablePdb::parse(&buf).unwrap();
+
+    let mut converter = PortablePdbCacheConverter::new();
+    converter.process_portable_pdb(&pdb).unwrap();
+    let mut buf = Vec::new();
+    converter.serialize(&mut buf).unwrap();
+
+    let cache = PortablePdbCache::parse(&buf).unwrap();
+
+    // Unsorted, with repeated functions and offsets, and functions without any ranges.
+    let mut frames = Vec::new();
+    for func_idx in (0..12).rev() {
+        for il_offset in [40, 0, 6, 10, 10, 1000, 3] {
+            frames.push((func_idx, il_offset));
+        }
+    }
+
+    let mut seen = vec![false; frames.len()];
+    for (idx, info) in cache.lookup_many(&frames) {
+        let (func_idx, il_offset) = frames[idx];
+        assert_eq!(
+            info,
+            cache.lookup(func_idx, il_offset),
+            "{func_idx}:{il_offset}"
+        );
+        seen[idx] = true;
+    }
+    assert!(seen.iter().all(|&seen| seen));
+
+    frames.sort();
+    let sorted: Vec<_> = cache.lookup_many(&frames).map(|(idx, _)| idx).collect();
+    assert_eq!(sorted, (0..frames.len()).collect::<Vec<_>>());
+}
+
+#[test]
+fn test_cache_map() {
+    let buf = std::fs::read(fixture("windows/portable.pdb")).unwrap();
+
+    let pdb = PortablePdb::parse(&buf).unwrap();
+    let debug_id = pdb.pdb_id().unwrap();
+
+    let mut converter = PortablePdbCacheConverter::new();
+    converter.process_portable_pdb(&pdb).unwrap();
+    let mut buf = Vec::new();
+    converter.serialize(&mut buf).unwrap();
+
+    let map = PortablePdbCacheMap::new(16 << 20);
+    assert!(map.get(debug_id).is_none());
+
+    let cache = map.insert(ByteView::from_vec(buf.clone())).unwrap();
+    assert_eq!(cache.get().debug_id(), debug_id);
+    assert_eq!(cache.get().lookup(7, 10).unwrap().line, 81);
+
+    let cached = map
+        .get_or_load(debug_id, || -> Result<_, CacheError> { unreachable!() })
+        .unwrap();
+    assert!(Arc::ptr_eq(&cache, &cached));
+
+    let stats = map.stats();
+    assert_eq!((stats.hits, stats.misses, stats.entries), (1, 1, 1));
+
+    // Caches exceeding the budget are returned, but not kept.
+    let map = PortablePdbCacheMap::new(buf.len());
+    let cache = map
+        .get_or_load(debug_id, || Ok::<_, CacheError>(ByteView::from_vec(buf)))
+        .unwrap();
+    assert_eq!(cache.get().debug_id(), debug_id);
+    assert!(map.get(debug_id).is_none());
+    assert_eq!(map.stats().entries, 0);
+}
+
+#[test]
+fn test_cache_map_keeps_new_caches() {
+    let buf = std::fs::read(fixture("windows/portable.pdb")).unwrap();
+
+    let pdb = PortablePdb::parse(&buf).unwrap();
+    let uuid = pdb.pdb_id().unwrap().uuid();
+
+    let mut converter = PortablePdbCacheConverter::new();
+    converter.process_portable_pdb(&pdb).unwrap();
+    let mut buf = Vec::new();
+    converter.serialize(&mut buf).unwrap();
+    let data = ByteView::from_vec(buf);
+
+    // Measure the size of one entry, and size the map so that every shard fits exactly one.
+    let probe = PortablePdbCacheMap::new(usize::MAX);
+    probe.insert(data.clone()).unwrap();
+    let map = PortablePdbCacheMap::new(probe.stats().bytes * 16);
+
+    // Every cache is hit right after it is loaded, so shards are full of hot caches. A newly
+    // loaded cache must replace them rather than being evicted itself.
+    for appendix in 0..64 {
+        let debug_id = DebugId::from_parts(uuid, appendix);
+        map.get_or_load(debug_id, || Ok::<_, CacheError>(data.clone()))
+            .unwrap();
+        assert!(map.get(debug_id).is_some(), "{debug_id} was evicted");
+    }
+
+    let stats = map.stats();
+    assert!(stats.evictions > 0);
+    assert_eq!(stats.entries as u64, 64 - stats.evictions);
+}
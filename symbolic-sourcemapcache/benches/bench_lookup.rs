@@ -0,0 +1,80 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use symbolic_sourcemapcache::{SourceMapCache, SourceMapCacheWriter, SourcePosition};
+use symbolic_testutils::{fixture, Rng};
+
+/// Creates a batch of `len` random positions within the lines of `minified`, resembling the frames
+/// of a JavaScript stack trace.
+fn positions(minified: &str, len: usize) -> Vec<SourcePosition> {
+    let lines: Vec<usize> = minified.lines().map(str::len).collect();
+    let mut rng = Rng::new();
+
+    (0..len)
+        .map(|_| {
+            let line = rng.next_u64() as usize % lines.len();
+            let column = rng.next_u64() as usize % lines[line].max(1);
+            SourcePosition::new(line as u32, column as u32)
+        })
+        .collect()
+}
+
+fn bench_lookup(c: &mut Criterion) {
+    let mut group = c.benchmark_group("lookup");
+
+    for (name, minified, map) in [
+        (
+            "preact",
+            "sourcemapcache/preact.module.js",
+            "sourcemapcache/preact.module.js.map",
+        ),
+        (
+            "metro",
+            "sourcemapcache/hermes-metro/react-native-metro.js",
+            "sourcemapcache/hermes-metro/react-native-metro.js.map",
+        ),
+    ] {
+        let minified = std::fs::read_to_string(fixture(minified)).unwrap();
+        let map = std::fs::read_to_string(fixture(map)).unwrap();
+
+        let mut buf = Vec::new();
+        let writer = SourceMapCacheWriter::new(&minified, &map).unwrap();
+        writer.serialize(&mut buf).unwrap();
+        let cache = SourceMapCache::parse(&buf).unwrap();
+
+        for len in [50, 200] {
+            let positions = positions(&minified, len);
+            let id = format!("{name}/{len}");
+            group.throughput(Throughput::Elements(len as u64));
+
+            group.bench_with_input(
+                BenchmarkId::new("lookup", &id),
+                &positions,
+                |b, positions| {
+                    b.iter(|| {
+                        for &sp in positions {
+                            criterion::black_box(cache.lookup(sp));
+                        }
+                    })
+                },
+            );
+
+            group.bench_with_input(
+                BenchmarkId::new("lookup_many", &id),
+                &positions,
+                |b, positions| {
+                    b.iter(|| {
+                        for result in cache.lookup_many(positions) {
+                            criterion::black_box(result);
+                        }
+                    })
+                },
+            );
+        }
+    }
+
+    group.finish();
+}
+
+criterion_group!(bench_lookups, bench_lookup);
+
+criterion_main!(bench_lookups);
@@ -0,0 +1,176 @@
+//! Measures the peak memory of converting a large generated SourceMap.
+//!
+//! Every conversion runs in a child process, which reports its peak resident set size from
+//! `/proc/self/status`. This only works on Linux. Set `SOURCEMAPCACHE_BENCH_LINES` to change the
+//! number of generated lines, which defaults to 500,000 with four tokens each.
+
+use std::fmt::Write as _;
+use std::process::Command;
+
+use symbolic_sourcemapcache::SourceMapCacheWriter;
+
+use utils::write_vlq;
+
+mod utils;
+
+const MODE_VAR: &str = "SOURCEMAPCACHE_BENCH_MODE";
+const LINES_VAR: &str = "SOURCEMAPCACHE_BENCH_LINES";
+
+/// The number of original source files referenced by the SourceMap.
+const FILES: usize = 100;
+
+/// Generates a minified source with one function per line and a SourceMap for `lines`.
+///
+/// If `sections` is greater than one, an index SourceMap with that many sections is generated.
+fn generate(lines: usize, sections: usize) -> (String, String) {
+    let mut source = String::new();
+    for line in 0..lines {
+        writeln!(source, "function f{line}(a){{return a+{line}}}").unwrap();
+    }
+
+    let section_lines = lines.div_ceil(sections.max(1));
+    let mut maps = Vec::new();
+    for start in (0..lines).step_by(section_lines.max(1)) {
+        let end = (start + section_lines).min(lines);
+
+        let mut map = String::from(r#"{"version":3,"sources":["#);
+        for file in 0..FILES {
+            let sep = if file > 0 { "," } else { "" };
+            write!(map, r#"{sep}"src/file{file}.js""#).unwrap();
+        }
+        map.push_str(r#"],"sourcesContent":["#);
+        for file in 0..FILES {
+            let sep = if file > 0 { "," } else { "" };
+            write!(
+                map,
+                r#"{sep}"// file {file}\nexport function f(a) {{\n  return a;\n}}\n""#
+            )
+            .unwrap();
+        }
+        map.push_str(r#"],"names":["#);
+        for line in start..end {
+            let sep = if line > start { "," } else { "" };
+            write!(map, r#"{sep}"original{line}""#).unwrap();
+        }
+        map.push_str(r#"],"mappings":""#);
+
+        let (mut prev_file, mut prev_line, mut prev_col, mut prev_name) = (0, 0, 0, 0);
+        for line in start..end {
+            if line > start {
+                map.push(';');
+            }
+            let file = (line % FILES) as i64;
+            let orig_line = (line / FILES) as i64;
+            let name = (line - start) as i64;
+
+            // `function`, the function name, the parameter and the return statement.
+            let mut prev_dst = 0;
+            for (token, (dst, orig_col)) in [
+                (0, 0),
+                (9, 16),
+                (line_len(line, 1), 18),
+                (line_len(line, 4), 2),
+            ]
+            .into_iter()
+            .enumerate()
+            {
+                if token > 0 {
+                    map.push(',');
+                }
+                write_vlq(&mut map, dst - prev_dst);
+                write_vlq(&mut map, file - prev_file);
+                write_vlq(&mut map, orig_line + (token > 1) as i64 - prev_line);
+                write_vlq(&mut map, orig_col - prev_col);
+                prev_dst = dst;
+                prev_file = file;
+                prev_line = orig_line + (token > 1) as i64;
+                prev_col = orig_col;
+
+                if token == 1 {
+                    write_vlq(&mut map, name - prev_name);
+                    prev_name = name;
+                }
+            }
+        }
+        map.push_str(r#""}"#);
+
+        maps.push((start, map));
+    }
+
+    if sections <= 1 {
+        return (source, maps.pop().map(|(_, map)| map).unwrap_or_default());
+    }
+
+    let mut index = String::from(r#"{"version":3,"sections":["#);
+    for (i, (start, map)) in maps.iter().enumerate() {
+        let sep = if i > 0 { "," } else { "" };
+        write!(
+            index,
+            r#"{sep}{{"offset":{{"line":{start},"column":0}},"map":{map}}}"#
+        )
+        .unwrap();
+    }
+    index.push_str("]}");
+
+    (source, index)
+}
+
+/// Returns the column after the function name on `line` plus `extra`.
+fn line_len(line: usize, extra: i64) -> i64 {
+    ("function f".len() + line.to_string().len()) as i64 + extra
+}
+
+/// Returns the peak resident set size of this process in KiB.
+fn peak_rss() -> Option<u64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|line| line.starts_with("VmHWM:"))?;
+    line.split_whitespace().nth(1)?.parse().ok()
+}
+
+fn run_child(mode: &str, lines: usize) {
+    let sections = if mode.ends_with("index") { 8 } else { 1 };
+    let (source, map) = generate(lines, sections);
+    let baseline = peak_rss().unwrap_or_default();
+
+    let mut sink = std::io::sink();
+    if mode.starts_with("direct") {
+        SourceMapCacheWriter::write_direct(&source, &map, &mut sink).unwrap();
+    } else {
+        let writer = SourceMapCacheWriter::new(&source, &map).unwrap();
+        writer.serialize(&mut sink).unwrap();
+    }
+
+    let peak = peak_rss().unwrap_or_default();
+    println!(
+        "{mode:<18} input {:>7} KiB   peak {:>8} KiB   conversion {:>8} KiB",
+        (source.len() + map.len()) / 1024,
+        peak,
+        peak.saturating_sub(baseline)
+    );
+}
+
+fn main() {
+    let lines = std::env::var(LINES_VAR)
+        .ok()
+        .and_then(|lines| lines.parse().ok())
+        .unwrap_or(500_000);
+
+    if let Ok(mode) = std::env::var(MODE_VAR) {
+        return run_child(&mode, lines);
+    }
+
+    if peak_rss().is_none() {
+        println!("peak memory can only be measured on Linux");
+        return;
+    }
+
+    let exe = std::env::current_exe().unwrap();
+    for mode in ["serialize", "direct", "serialize-index", "direct-index"] {
+        let status = Command::new(&exe)
+            .env(MODE_VAR, mode)
+            .env(LINES_VAR, lines.to_string())
+            .status()
+            .unwrap();
+        assert!(status.success(), "{mode} failed");
+    }
+}
@@ -0,0 +1,77 @@
+use std::fmt::Write as _;
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+
+use symbolic_sourcemapcache::SourceMapCacheWriter;
+
+use utils::write_vlq;
+
+mod utils;
+
+/// The number of generated functions, each of which is a separate scope.
+const FUNCTIONS: usize = 20_000;
+
+/// Generates a minified source with one minified function per line, and a SourceMap that maps
+/// every function name to an original name.
+fn generate() -> (String, String) {
+    let mut source = String::new();
+    let mut names = String::new();
+    let mut mappings = String::new();
+
+    for function in 0..FUNCTIONS {
+        writeln!(source, "function f{function}(a){{return a+{function}}}").unwrap();
+
+        let sep = if function > 0 { "," } else { "" };
+        write!(names, r#"{sep}"originalFunction{function}""#).unwrap();
+
+        if function > 0 {
+            mappings.push(';');
+        }
+        let first = function == 0;
+
+        // `function`, mapped to the start of the next original line.
+        write_vlq(&mut mappings, 0);
+        write_vlq(&mut mappings, 0);
+        write_vlq(&mut mappings, if first { 0 } else { 1 });
+        write_vlq(&mut mappings, if first { 0 } else { -16 });
+        mappings.push(',');
+
+        // The function name, mapped to its original name.
+        write_vlq(&mut mappings, 9);
+        write_vlq(&mut mappings, 0);
+        write_vlq(&mut mappings, 0);
+        write_vlq(&mut mappings, 16);
+        write_vlq(&mut mappings, if first { 0 } else { 1 });
+    }
+
+    let map = format!(
+        r#"{{"version":3,"sources":["original.js"],"names":[{names}],"mappings":"{mappings}"}}"#
+    );
+    (source, map)
+}
+
+fn bench_writer_threads(c: &mut Criterion) {
+    let (source, map) = generate();
+    let mut group = c.benchmark_group("SourceMapCacheWriter");
+
+    for threads in [1, 2, 4, 8] {
+        group.bench_with_input(
+            BenchmarkId::new("with_threads", threads),
+            &threads,
+            |b, &threads| {
+                b.iter(|| {
+                    let writer =
+                        SourceMapCacheWriter::with_threads(&source, &map, threads).unwrap();
+                    let mut buf = Vec::new();
+                    writer.serialize(&mut buf).unwrap();
+                    buf
+                })
+            },
+        );
+    }
+
+    group.finish();
+}
+
+criterion_group!(benches, bench_writer_threads);
+criterion_main!(benches);
@@ -0,0 +1,24 @@
+//! Helpers to generate SourceMaps for benchmarks.
+
+const BASE64: &[u8] = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/// Appends `value` to SourceMap `mappings` as a base64 VLQ.
+pub fn write_vlq(out: &mut String, value: i64) {
+    let mut value = if value < 0 {
+        ((-value) << 1) | 1
+    } else {
+        value << 1
+    };
+
+    loop {
+        let mut digit = value & 0b11111;
+        value >>= 5;
+        if value > 0 {
+            digit |= 0b100000;
+        }
+        out.push(BASE64[digit as usize] as char);
+        if value == 0 {
+            break;
+        }
+    }
+}
@@ -1,4 +1,4 @@
-use symbolic_common::AsSelf;
+use symbolic_common::{gallop, AsSelf};
 use watto::{align_to, Pod, StringTable};
 
 use crate::{ScopeLookupResult, SourcePosition};
@@ -171,12 +171,47 @@ impl<'data> SourceMapCache<'data> {
     /// to the original [`SourceLocation`].
     #[tracing::instrument(level = "trace", name = "SourceMapCache::lookup", skip_all)]
     pub fn lookup(&self, sp: SourcePosition) -> Option<SourceLocation<'_>> {
-        let idx = match self.min_source_positions.binary_search(&sp.into()) {
-            Ok(idx) => idx,
-            Err(0) => return None,
-            Err(idx) => idx - 1,
+        // Take the last mapping at or before `sp`. Unlike `binary_search`, this picks the same
+        // mapping as `lookup_many` if there are several at the same position.
+        let key = raw::MinifiedSourcePosition::from(sp);
+        let idx = self
+            .min_source_positions
+            .partition_point(|mapping| *mapping <= key)
+            .checked_sub(1)?;
+
+        self.location_at(idx, sp)
+    }
+
+    /// Looks up many [`SourcePosition`]s in a single sweep over the cache.
+    ///
+    /// This is faster than calling [`lookup`](Self::lookup) for each position, since every lookup
+    /// continues from the previous one instead of searching all mappings. It is particularly
+    /// efficient for the frames of a stack trace, which often point into the same few functions.
+    ///
+    /// Every item is an index into `positions` together with the [`SourceLocation`] it resolves
+    /// to, or `None`. Items are ordered by line and column, which for sorted input is simply the
+    /// order of `positions`.
+    pub fn lookup_many<'a>(&'a self, positions: &'a [SourcePosition]) -> LookupMany<'data, 'a> {
+        let key = |idx: usize| raw::MinifiedSourcePosition::from(positions[idx]);
+        let order = if (0..positions.len()).map(key).is_sorted() {
+            None
+        } else {
+            let mut order: Vec<usize> = (0..positions.len()).collect();
+            order.sort_unstable_by_key(|&idx| (key(idx), idx));
+            Some(order)
         };
 
+        LookupMany {
+            cache: self,
+            positions,
+            order,
+            position: 0,
+            cursor: 0,
+        }
+    }
+
+    /// Resolves the mapping at `idx`, which is the last mapping at or before `sp`.
+    fn location_at(&self, idx: usize, sp: SourcePosition) -> Option<SourceLocation<'data>> {
         // If the token has a lower minified line number,
         // it actually belongs to the previous line. That means it should
         // not match.
@@ -227,6 +262,50 @@ impl<'data> SourceMapCache<'data> {
     }
 }
 
+/// Iterator returned by [`SourceMapCache::lookup_many`]; see documentation there.
+#[derive(Debug, Clone)]
+pub struct LookupMany<'data, 'cache> {
+    cache: &'cache SourceMapCache<'data>,
+    positions: &'cache [SourcePosition],
+    /// Indexes into `positions` in ascending order, or `None` if `positions` is sorted.
+    order: Option<Vec<usize>>,
+    /// The next position in `order`.
+    position: usize,
+    /// The number of mappings at or before the previous position.
+    cursor: usize,
+}
+
+impl<'data> Iterator for LookupMany<'data, '_> {
+    type Item = (usize, Option<SourceLocation<'data>>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let idx = match self.order {
+            Some(ref order) => *order.get(self.position)?,
+            None if self.position < self.positions.len() => self.position,
+            None => return None,
+        };
+        self.position += 1;
+
+        let sp = self.positions[idx];
+        let cache = self.cache;
+        let min_sp = raw::MinifiedSourcePosition::from(sp);
+        self.cursor = gallop(cache.min_source_positions, self.cursor, |m| *m <= min_sp);
+        let location = match self.cursor {
+            0 => None,
+            cursor => cache.location_at(cursor - 1, sp),
+        };
+
+        Some((idx, location))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let len = self.positions.len() - self.position;
+        (len, Some(len))
+    }
+}
+
+impl ExactSizeIterator for LookupMany<'_, '_> {}
+
 /// An Error that can happen when parsing a [`SourceMapCache`].
 #[derive(thiserror::Error, Debug)]
 #[non_exhaustive]
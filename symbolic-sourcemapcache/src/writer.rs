@@ -1,17 +1,23 @@
+use std::borrow::Cow;
+use std::collections::HashMap;
 use std::io::Write;
 use std::ops::Range;
 
 use itertools::Itertools;
 use js_source_scopes::{
-    extract_scope_names, NameResolver, ScopeIndex, ScopeIndexError, SourceContext,
+    extract_scope_names, NameResolver, ScopeIndex, ScopeIndexError, ScopeName, SourceContext,
     SourceContextError,
 };
-use sourcemap::DecodedMap;
+use sourcemap::{DecodedMap, SourceMap};
+use symbolic_common::{parallel_map, CHUNKS_PER_THREAD};
 use watto::{Pod, StringTable, Writer};
 
 use super::raw;
 use super::{ScopeLookupResult, SourcePosition};
 
+/// The minimum number of scopes resolved at once by a thread.
+const MIN_SCOPES_PER_CHUNK: usize = 16;
+
 /// A structure that allows quick resolution of minified source position
 /// to the original source position it maps to.
 pub struct SourceMapCacheWriter {
@@ -21,10 +27,37 @@ pub struct SourceMapCacheWriter {
     mappings: Vec<(raw::MinifiedSourcePosition, raw::OriginalSourceLocation)>,
 }
 
+/// The tokens of a SourceMap, or of one section of an index SourceMap.
+struct TokenSource<'a> {
+    map: Cow<'a, SourceMap>,
+    /// The position of the section in the minified file.
+    offset: (u32, u32),
+    /// The index in the file table of every source of `map`.
+    files: Vec<u32>,
+}
+
 impl SourceMapCacheWriter {
     /// Constructs a new Cache from a minified source file and its corresponding SourceMap.
     #[tracing::instrument(level = "trace", name = "SourceMapCacheWriter::new", skip_all)]
     pub fn new(source: &str, sourcemap: &str) -> Result<Self, SourceMapCacheWriterError> {
+        Self::with_threads(source, sourcemap, 1)
+    }
+
+    /// Constructs a new Cache like [`new`](Self::new), resolving scope names on up to `threads`
+    /// threads.
+    ///
+    /// Resolving the original names of scopes dominates the conversion time for large minified
+    /// sources. The result is identical to [`new`](Self::new) regardless of the number of threads.
+    #[tracing::instrument(
+        level = "trace",
+        name = "SourceMapCacheWriter::with_threads",
+        skip(source, sourcemap)
+    )]
+    pub fn with_threads(
+        source: &str,
+        sourcemap: &str,
+        threads: usize,
+    ) -> Result<Self, SourceMapCacheWriterError> {
         let sm = tracing::trace_span!("decode sourcemap").in_scope(
             || -> Result<DecodedMap, SourceMapCacheWriterError> {
                 let sm = sourcemap::decode_slice(sourcemap.as_bytes())
@@ -40,46 +73,118 @@ impl SourceMapCacheWriter {
             },
         )?;
 
-        let tokens = match &sm {
-            DecodedMap::Regular(sm) => sm.tokens(),
-            DecodedMap::Hermes(smh) => smh.tokens(),
-            DecodedMap::Index(_smi) => unreachable!(),
-        };
+        Self::convert(source, &sm, threads)
+    }
+
+    /// Converts a minified source file and its corresponding SourceMap, and writes the
+    /// SourceMapCache binary format into the given [`Write`].
+    ///
+    /// This is equivalent to [`new`](Self::new) followed by [`serialize`](Self::serialize), except
+    /// for index SourceMaps: [`new`](Self::new) flattens them into a copy of all their tokens,
+    /// while this reads the tokens of every section in place. For regular SourceMaps, there is no
+    /// difference in output or memory use.
+    ///
+    /// As in a flattened SourceMap, sources that appear in several sections are listed once in
+    /// the file table. Scope names, however, are resolved against the sections rather than the
+    /// flattened tokens, so the scope of positions close to the start of a section can differ from
+    /// [`new`](Self::new). Sections that reference another SourceMap by URL are skipped, while
+    /// [`new`](Self::new) fails to flatten them.
+    #[tracing::instrument(level = "trace", name = "SourceMapCacheWriter::write_direct", skip_all)]
+    pub fn write_direct<W: Write>(
+        source: &str,
+        sourcemap: &str,
+        writer: &mut W,
+    ) -> Result<(), SourceMapCacheWriterError> {
+        let sm = tracing::trace_span!("decode sourcemap").in_scope(|| {
+            sourcemap::decode_slice(sourcemap.as_bytes())
+                .map_err(SourceMapCacheErrorInner::SourceMap)
+        })?;
+
+        Self::convert(source, &sm, 1)?
+            .serialize(writer)
+            .map_err(SourceMapCacheErrorInner::Io)?;
+        Ok(())
+    }
+
+    /// Converts a decoded SourceMap, resolving scope names on up to `threads` threads.
+    fn convert(
+        source: &str,
+        sm: &DecodedMap,
+        threads: usize,
+    ) -> Result<Self, SourceMapCacheWriterError> {
+        let (ctx, scope_index) = Self::resolve_scopes(source, sm, threads)?;
+        let scope_index = Self::convert_scope_index(&ctx, &scope_index);
+
+        let mut string_table = StringTable::new();
+        let mut line_offsets = vec![];
+        let mut files = vec![];
+        let token_sources = tracing::trace_span!("extract original files").in_scope(|| {
+            Self::token_sources(sm, &mut string_table, &mut files, &mut line_offsets)
+        })?;
+
+        // iterate over the tokens and create our index
+        let mut mappings = Vec::new();
+        tracing::trace_span!("create index").in_scope(|| {
+            Self::for_each_mapping(
+                &token_sources,
+                |sp| Self::lookup_scope(sm, &scope_index, sp),
+                |s| string_table.insert(s) as u32,
+                |min_sp, orig_sl| mappings.push((min_sp, orig_sl)),
+            )
+        });
 
+        Ok(Self {
+            string_table,
+            files,
+            line_offsets,
+            mappings,
+        })
+    }
+
+    /// Extracts the scopes of the minified source and resolves them to their original names on up
+    /// to `threads` threads.
+    fn resolve_scopes<'s>(
+        source: &'s str,
+        sm: &DecodedMap,
+        threads: usize,
+    ) -> Result<(SourceContext<&'s str>, ScopeIndex), SourceMapCacheWriterError> {
         // Hermes/Metro SourceMaps have scope information embedded in them which we can use.
         // In that case, we can skip parsing the minified source, which in most cases is empty / non-existent
         // as Hermes ships bytecode that we are not able to parse anyway.
         // Skipping this whole code would be nice, but that gets us into borrow-checker hell, so
         // just clearing the minified source skips the whole code there anyways.
-        let source = if matches!(&sm, DecodedMap::Hermes(_)) {
+        let source = if matches!(sm, DecodedMap::Hermes(_)) {
             ""
         } else {
             source
         };
 
         // parse scopes out of the minified source
-        let scopes = match extract_scope_names(source) {
-            Ok(scopes) => scopes,
-            Err(err) => {
-                let err: &dyn std::error::Error = &err;
-                tracing::error!(error = err, "failed parsing minified source");
-                // even if the minified source failed parsing, we can still use the information
-                // from the sourcemap itself.
-                vec![]
+        let scopes = tracing::trace_span!("extract scope names").in_scope(|| {
+            match extract_scope_names(source) {
+                Ok(scopes) => scopes,
+                Err(err) => {
+                    let err: &dyn std::error::Error = &err;
+                    tracing::error!(error = err, "failed parsing minified source");
+                    // even if the minified source failed parsing, we can still use the information
+                    // from the sourcemap itself.
+                    vec![]
+                }
             }
-        };
+        });
 
         // resolve scopes to original names
         let ctx = SourceContext::new(source).map_err(SourceMapCacheErrorInner::SourceContext)?;
-        let resolver = NameResolver::new(&ctx, &sm);
 
-        let scopes: Vec<_> = tracing::trace_span!("resolve original names").in_scope(|| {
-            scopes
-                .into_iter()
+        let resolve_chunk = |chunk: &[(Range<u32>, Option<ScopeName>)]| -> Vec<_> {
+            let resolver = NameResolver::new(&ctx, sm);
+            chunk
+                .iter()
                 .map(|(range, name)| {
                     let orig_name = name.as_ref().map(|name| name.to_string());
                     let resolved_name = name
-                        .map(|n| resolver.resolve_name(&n))
+                        .as_ref()
+                        .map(|n| resolver.resolve_name(n))
                         .filter(|s| !s.is_empty());
 
                     // A hack specifically for Flutter. If the resolved scope name is the same as the original name,
@@ -87,19 +192,45 @@ impl SourceMapCacheWriter {
                     // at the very end of the scope, if it exists, and use it instead of the "conventionally"
                     // resolved scope.
                     let name_at_end_of_scope = if orig_name == resolved_name {
-                        Self::try_resolve_closing_name(&ctx, &sm, range.clone())
+                        Self::try_resolve_closing_name(&ctx, sm, range.clone())
                     } else {
                         None
                     };
 
-                    (range, name_at_end_of_scope.or(resolved_name))
+                    (range.clone(), name_at_end_of_scope.or(resolved_name))
                 })
                 .collect()
-        });
+        };
+
+        let threads = threads.max(1);
+        let chunk_size = scopes
+            .len()
+            .div_ceil(threads * CHUNKS_PER_THREAD)
+            .max(MIN_SCOPES_PER_CHUNK);
+        let chunks: Vec<_> = scopes.chunks(chunk_size).collect();
+        let threads = threads.min(chunks.len()).max(1);
+        let scopes: Vec<_> =
+            tracing::trace_span!("resolve original names", threads).in_scope(|| {
+                // Chunks are reassembled in order, so that the scope index is identical to a
+                // serial build.
+                parallel_map(&chunks, threads, |chunk| resolve_chunk(chunk))
+                    .into_iter()
+                    .flatten()
+                    .collect()
+            });
+
+        let scope_index = tracing::trace_span!("build scope index")
+            .in_scope(|| ScopeIndex::new(scopes))
+            .map_err(SourceMapCacheErrorInner::ScopeIndex)?;
+        Ok((ctx, scope_index))
+    }
 
-        // convert our offset index to a source position index
-        let scope_index = ScopeIndex::new(scopes).map_err(SourceMapCacheErrorInner::ScopeIndex)?;
-        let scope_index: Vec<_> = tracing::trace_span!("convert scope index").in_scope(|| {
+    /// Converts the offsets of a scope index to source positions.
+    fn convert_scope_index<'i>(
+        ctx: &SourceContext<&str>,
+        scope_index: &'i ScopeIndex,
+    ) -> Vec<(SourcePosition, ScopeLookupResult<'i>)> {
+        tracing::trace_span!("convert scope index").in_scope(|| {
             scope_index
                 .iter()
                 .filter_map(|(offset, result)| {
@@ -107,81 +238,154 @@ impl SourceMapCacheWriter {
                     pos.map(|pos| (pos, result))
                 })
                 .collect()
-        });
-        let lookup_scope = |sp: &SourcePosition| {
-            if let DecodedMap::Hermes(smh) = &sm {
-                let token = smh.lookup_token(sp.line, sp.column);
-                return match token.and_then(|token| smh.get_scope_for_token(token)) {
-                    Some(name) => ScopeLookupResult::NamedScope(name),
-                    None => ScopeLookupResult::Unknown,
-                };
-            }
+        })
+    }
 
-            let idx = match scope_index.binary_search_by_key(&sp, |idx| &idx.0) {
-                Ok(idx) => idx,
-                Err(0) => 0,
-                Err(idx) => idx - 1,
-            };
-            match scope_index.get(idx) {
-                Some(r) => r.1,
+    /// Returns the scope containing the given position in the minified source.
+    fn lookup_scope<'a>(
+        sm: &'a DecodedMap,
+        scope_index: &[(SourcePosition, ScopeLookupResult<'a>)],
+        sp: &SourcePosition,
+    ) -> ScopeLookupResult<'a> {
+        if let DecodedMap::Hermes(smh) = sm {
+            let token = smh.lookup_token(sp.line, sp.column);
+            return match token.and_then(|token| smh.get_scope_for_token(token)) {
+                Some(name) => ScopeLookupResult::NamedScope(name),
                 None => ScopeLookupResult::Unknown,
-            }
-        };
+            };
+        }
 
-        let orig_files = match &sm {
-            DecodedMap::Regular(sm) => sm
-                .sources()
-                .zip_longest(sm.source_contents().map(Option::unwrap_or_default)),
-            DecodedMap::Hermes(smh) => smh
-                .sources()
-                .zip_longest(smh.source_contents().map(Option::unwrap_or_default)),
-            DecodedMap::Index(_smi) => unreachable!(),
+        let idx = match scope_index.binary_search_by_key(&sp, |idx| &idx.0) {
+            Ok(idx) => idx,
+            Err(0) => 0,
+            Err(idx) => idx - 1,
         };
+        match scope_index.get(idx) {
+            Some(r) => r.1,
+            None => ScopeLookupResult::Unknown,
+        }
+    }
 
-        let mut string_table = StringTable::new();
-        let mut mappings = Vec::new();
-
-        let mut line_offsets = vec![];
-        let mut files = vec![];
-        tracing::trace_span!("extract original files").in_scope(|| {
-            for orig_file in orig_files {
-                let (name, source) = orig_file.or_default();
-                let name_offset = string_table.insert(name) as u32;
-                let source_offset = string_table.insert(source) as u32;
-                let line_offsets_start = line_offsets.len() as u32;
-                Self::append_line_offsets(source, &mut line_offsets);
-                let line_offsets_end = line_offsets.len() as u32;
-
-                files.push((
-                    name,
-                    raw::File {
-                        name_offset,
-                        source_offset,
-                        line_offsets_start,
-                        line_offsets_end,
-                    },
-                ));
+    /// Adds the original files of a SourceMap to the file table and returns the tokens to convert.
+    ///
+    /// Index SourceMaps are not flattened. Instead, every section becomes a separate token source
+    /// with its own mapping to the file table. Like [`SourceMapIndex::flatten`], sources with the
+    /// same name in several sections are merged into one file, which takes the contents of the last
+    /// section that has any.
+    ///
+    /// [`SourceMapIndex::flatten`]: sourcemap::SourceMapIndex::flatten
+    fn token_sources<'a>(
+        sm: &'a DecodedMap,
+        string_table: &mut StringTable,
+        files: &mut Vec<raw::File>,
+        line_offsets: &mut Vec<raw::LineOffset>,
+    ) -> Result<Vec<TokenSource<'a>>, SourceMapCacheWriterError> {
+        let mut sections = Vec::new();
+        match sm {
+            DecodedMap::Regular(sm) => sections.push(((0, 0), Cow::Borrowed(sm))),
+            DecodedMap::Hermes(smh) => sections.push(((0, 0), Cow::Borrowed(&**smh))),
+            DecodedMap::Index(smi) => {
+                for section in smi.sections() {
+                    let map = match section.get_sourcemap() {
+                        Some(DecodedMap::Regular(sm)) => Cow::Borrowed(sm),
+                        Some(DecodedMap::Hermes(smh)) => Cow::Borrowed(&**smh),
+                        Some(DecodedMap::Index(smi)) => {
+                            Cow::Owned(smi.flatten().map_err(SourceMapCacheErrorInner::SourceMap)?)
+                        }
+                        None => continue,
+                    };
+                    sections.push((section.get_offset(), map));
+                }
             }
-        });
+        }
 
-        // iterate over the tokens and create our index
+        let merge_sources = matches!(sm, DecodedMap::Index(_));
+        let mut sources: Vec<(&str, Option<&str>)> = Vec::new();
+        let mut source_ids = HashMap::new();
+        let mut section_files = Vec::with_capacity(sections.len());
+
+        for (_, map) in &sections {
+            let orig_files = map.sources().zip_longest(map.source_contents());
+            let ids = orig_files
+                .map(|orig_file| {
+                    let (name, contents) = orig_file.or_default();
+                    match source_ids.get(name) {
+                        Some(&id) if merge_sources => {
+                            let source = &mut sources[id as usize];
+                            source.1 = contents.or(source.1);
+                            id
+                        }
+                        _ => {
+                            let id = sources.len() as u32;
+                            sources.push((name, contents));
+                            source_ids.insert(name, id);
+                            id
+                        }
+                    }
+                })
+                .collect::<Vec<_>>();
+            section_files.push(ids);
+        }
+
+        for (name, source) in sources {
+            let source = source.unwrap_or_default();
+            let name_offset = string_table.insert(name) as u32;
+            let source_offset = string_table.insert(source) as u32;
+            let line_offsets_start = line_offsets.len() as u32;
+            Self::append_line_offsets(source, line_offsets);
+            let line_offsets_end = line_offsets.len() as u32;
+
+            files.push(raw::File {
+                name_offset,
+                source_offset,
+                line_offsets_start,
+                line_offsets_end,
+            });
+        }
+
+        let token_sources = sections
+            .into_iter()
+            .zip(section_files)
+            .map(|((offset, map), files)| TokenSource { map, offset, files })
+            .collect();
+
+        Ok(token_sources)
+    }
+
+    /// Converts all tokens into mappings and calls `f` with each of them in order.
+    ///
+    /// Consecutive tokens that map to the same original location are merged. Strings are added to
+    /// the string table through `intern`, which returns their offset.
+    fn for_each_mapping<'a>(
+        token_sources: &'a [TokenSource<'a>],
+        lookup_scope: impl Fn(&SourcePosition) -> ScopeLookupResult<'a>,
+        mut intern: impl FnMut(&'a str) -> u32,
+        mut f: impl FnMut(raw::MinifiedSourcePosition, raw::OriginalSourceLocation),
+    ) {
         let mut last = None;
-        tracing::trace_span!("create index").in_scope(|| {
-            for token in tokens {
+        for token_source in token_sources {
+            let (offset_line, offset_column) = token_source.offset;
+            for token in token_source.map.tokens() {
                 let (min_line, min_col) = token.get_dst();
-                let sp = SourcePosition::new(min_line, min_col);
+                let min_col = if min_line == 0 {
+                    min_col + offset_column
+                } else {
+                    min_col
+                };
+                let sp = SourcePosition::new(min_line + offset_line, min_col);
                 let line = token.get_src_line();
                 let column = token.get_src_col();
                 let scope = lookup_scope(&sp);
-                let mut file_idx = token.get_src_id();
 
-                if file_idx >= files.len() as u32 {
-                    file_idx = raw::NO_FILE_SENTINEL;
-                }
+                let file_idx = token_source
+                    .files
+                    .get(token.get_src_id() as usize)
+                    .copied()
+                    .unwrap_or(raw::NO_FILE_SENTINEL);
 
                 let scope_idx = match scope {
                     ScopeLookupResult::NamedScope(name) => {
-                        std::cmp::min(string_table.insert(name) as u32, raw::GLOBAL_SCOPE_SENTINEL)
+                        std::cmp::min(intern(name), raw::GLOBAL_SCOPE_SENTINEL)
                     }
                     ScopeLookupResult::AnonymousScope => raw::ANONYMOUS_SCOPE_SENTINEL,
                     ScopeLookupResult::Unknown => raw::GLOBAL_SCOPE_SENTINEL,
@@ -189,7 +393,7 @@ impl SourceMapCacheWriter {
 
                 let name = token.get_name();
                 let name_idx = match name {
-                    Some(name) => string_table.insert(name) as u32,
+                    Some(name) => intern(name),
                     None => raw::NO_NAME_SENTINEL,
                 };
 
@@ -204,25 +408,16 @@ impl SourceMapCacheWriter {
                 if last == Some(sl) {
                     continue;
                 }
-                mappings.push((
+                f(
                     raw::MinifiedSourcePosition {
                         line: sp.line,
                         column: sp.column,
                     },
                     sl,
-                ));
+                );
                 last = Some(sl);
             }
-        });
-
-        let files = files.into_iter().map(|(_name, file)| file).collect();
-
-        Ok(Self {
-            string_table,
-            files,
-            line_offsets,
-            mappings,
-        })
+        }
     }
 
     /// Returns the name attached to the token at the given range's end, if any.
@@ -332,6 +527,7 @@ pub(crate) enum SourceMapCacheErrorInner {
     SourceMap(sourcemap::Error),
     ScopeIndex(ScopeIndexError),
     SourceContext(SourceContextError),
+    Io(std::io::Error),
 }
 
 impl std::error::Error for SourceMapCacheWriterError {}
@@ -342,6 +538,7 @@ impl std::fmt::Display for SourceMapCacheWriterError {
             SourceMapCacheErrorInner::SourceMap(e) => e.fmt(f),
             SourceMapCacheErrorInner::ScopeIndex(e) => e.fmt(f),
             SourceMapCacheErrorInner::SourceContext(e) => e.fmt(f),
+            SourceMapCacheErrorInner::Io(e) => e.fmt(f),
         }
     }
 }
@@ -287,3 +287,138 @@ fn webpack_scope_lookup() {
     assert_eq!(sl.scope(), ScopeLookupResult::NamedScope("module.exports"));
     assert_eq!(sl.line_contents().unwrap(), "  f();\n");
 }
+
+#[test]
+fn lookup_many_matches_lookup() {
+    let minified =
+        std::fs::read_to_string(fixture("sourcemapcache/hermes-metro/react-native-metro.js"))
+            .unwrap();
+    let map = std::fs::read_to_string(fixture(
+        "sourcemapcache/hermes-metro/react-native-metro.js.map",
+    ))
+    .unwrap();
+
+    let writer = SourceMapCacheWriter::new(&minified, &map).unwrap();
+
+    let mut buf = vec![];
+    writer.serialize(&mut buf).unwrap();
+
+    let cache = SourceMapCache::parse(&buf).unwrap();
+
+    // Every column of every line, including positions past the end of a line.
+    let sorted: Vec<_> = minified
+        .lines()
+        .enumerate()
+        .flat_map(|(line, contents)| {
+            (0..=contents.len() as u32 + 1).map(move |col| SourcePosition::new(line as u32, col))
+        })
+        .collect();
+
+    // Interleave from both ends, with duplicates, to force sorting.
+    let unsorted: Vec<_> = sorted
+        .iter()
+        .zip(sorted.iter().rev())
+        .flat_map(|(&a, &b)| [a, b])
+        .collect();
+
+    for positions in [&sorted, &unsorted] {
+        let mut seen = vec![false; positions.len()];
+        for (idx, location) in cache.lookup_many(positions) {
+            assert!(!seen[idx]);
+            seen[idx] = true;
+            assert_eq!(location, cache.lookup(positions[idx]));
+        }
+        assert!(seen.into_iter().all(|seen| seen));
+    }
+}
+
+#[test]
+fn write_direct_matches_serialize() {
+    for (minified, map) in [
+        ("preact.module.js", "preact.module.js.map"),
+        ("webpack/bundle.js", "webpack/bundle.js.map"),
+        ("inlining/module.js", "inlining/module.js.map"),
+        (
+            "hermes-metro/react-native-metro.js",
+            "hermes-metro/react-native-metro.js.map",
+        ),
+        ("", "hermes-metro/react-native-hermes.map"),
+    ] {
+        let minified = match minified {
+            "" => String::new(),
+            path => std::fs::read_to_string(fixture(format!("sourcemapcache/{path}"))).unwrap(),
+        };
+        let map = std::fs::read_to_string(fixture(format!("sourcemapcache/{map}"))).unwrap();
+
+        let mut expected = vec![];
+        let writer = SourceMapCacheWriter::new(&minified, &map).unwrap();
+        writer.serialize(&mut expected).unwrap();
+
+        let mut direct = vec![];
+        SourceMapCacheWriter::write_direct(&minified, &map, &mut direct).unwrap();
+
+        assert_eq!(direct, expected);
+    }
+}
+
+#[test]
+fn write_direct_index_map() {
+    let minified = std::fs::read_to_string(fixture("sourcemapcache/webpack/bundle.js")).unwrap();
+    let map = std::fs::read_to_string(fixture("sourcemapcache/webpack/bundle.js.map")).unwrap();
+
+    // Two copies of the same map, the second one starting on line 10.
+    let index = format!(
+        r#"{{"version":3,"sections":[{{"offset":{{"line":0,"column":0}},"map":{map}}},{{"offset":{{"line":10,"column":0}},"map":{map}}}]}}"#
+    );
+
+    let mut flattened = vec![];
+    let writer = SourceMapCacheWriter::new(&minified, &index).unwrap();
+    writer.serialize(&mut flattened).unwrap();
+    let flattened = SourceMapCache::parse(&flattened).unwrap();
+
+    let mut direct = vec![];
+    SourceMapCacheWriter::write_direct(&minified, &index, &mut direct).unwrap();
+    let direct = SourceMapCache::parse(&direct).unwrap();
+
+    // Both sections share their sources, which are listed only once.
+    let direct_files: Vec<_> = direct.files().map(|file| file.name()).collect();
+    let flattened_files: Vec<_> = flattened.files().map(|file| file.name()).collect();
+    assert_eq!(direct_files, flattened_files);
+
+    let mut resolved = 0;
+    for line in 0..12 {
+        for column in 0..minified.len() as u32 {
+            let sp = SourcePosition::new(line, column);
+            let location = direct.lookup(sp);
+            resolved += location.is_some() as usize;
+            assert_eq!(location, flattened.lookup(sp), "{line}:{column}");
+        }
+    }
+    assert!(resolved > 0);
+}
+
+#[test]
+fn with_threads_matches_new() {
+    for (minified, map) in [
+        ("preact.module.js", "preact.module.js.map"),
+        (
+            "hermes-metro/react-native-metro.js",
+            "hermes-metro/react-native-metro.js.map",
+        ),
+    ] {
+        let minified =
+            std::fs::read_to_string(fixture(format!("sourcemapcache/{minified}"))).unwrap();
+        let map = std::fs::read_to_string(fixture(format!("sourcemapcache/{map}"))).unwrap();
+
+        let mut expected = vec![];
+        let writer = SourceMapCacheWriter::new(&minified, &map).unwrap();
+        writer.serialize(&mut expected).unwrap();
+
+        for threads in [2, 3, 8] {
+            let mut buf = vec![];
+            let writer = SourceMapCacheWriter::with_threads(&minified, &map, threads).unwrap();
+            writer.serialize(&mut buf).unwrap();
+            assert_eq!(buf, expected, "{threads} threads");
+        }
+    }
+}
@@ -0,0 +1,112 @@
+//! Compares lookups with and without the range index on a large synthetic SymCache.
+//!
+//! Run with `cargo bench -p symbolic-symcache --features bench --bench bench_index`.
+
+use std::borrow::Cow;
+use std::io::Write;
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+
+use symbolic_common::ByteView;
+use symbolic_debuginfo::Symbol;
+use symbolic_symcache::{SymCache, SymCacheConverter};
+use symbolic_testutils::Rng;
+
+/// The number of symbols in the synthetic SymCache, which yields twice as many ranges.
+const NUM_SYMBOLS: u64 = 1 << 21;
+
+/// The distance between the start addresses of two symbols.
+const SYMBOL_STRIDE: u64 = 0x40;
+
+/// The number of lookups used to count page faults.
+const FAULT_LOOKUPS: usize = 10_000;
+
+/// Writes a SymCache with [`NUM_SYMBOLS`] symbols, each followed by a gap, to a temporary file.
+fn write_symcache() -> tempfile::NamedTempFile {
+    let mut converter = SymCacheConverter::new();
+    for i in 0..NUM_SYMBOLS {
+        converter.process_symbolic_symbol(&Symbol {
+            name: Some(Cow::Owned(format!("symbol_{i}"))),
+            address: i * SYMBOL_STRIDE,
+            size: SYMBOL_STRIDE / 2,
+        });
+    }
+
+    let mut buffer = Vec::new();
+    converter.serialize(&mut buffer).expect("serialize");
+
+    let mut file = tempfile::NamedTempFile::new().expect("tempfile");
+    file.write_all(&buffer).expect("write");
+    file
+}
+
+fn random_addrs(count: usize) -> Vec<u64> {
+    let mut rng = Rng::new();
+    (0..count)
+        .map(|_| rng.next_u64() % (NUM_SYMBOLS * SYMBOL_STRIDE))
+        .collect()
+}
+
+/// Returns the number of minor and major page faults of this process so far.
+fn page_faults() -> Option<(u64, u64)> {
+    let stat = std::fs::read_to_string("/proc/self/stat").ok()?;
+    // Fields after the parenthesized command name, starting with the process state (field 3).
+    let mut fields = stat.rsplit_once(')')?.1.split_whitespace();
+    let minor = fields.nth(7)?.parse().ok()?;
+    let major = fields.nth(1)?.parse().ok()?;
+    Some((minor, major))
+}
+
+/// Counts the page faults of lookups on a freshly mapped SymCache.
+fn report_page_faults(path: &std::path::Path) {
+    let addrs = random_addrs(FAULT_LOOKUPS);
+
+    for label in ["index", "binary search"] {
+        let buffer = ByteView::open(path).expect("open");
+        let symcache = SymCache::parse(&buffer).expect("parse");
+        let symcache = match label {
+            "index" => symcache,
+            _ => symcache.without_range_index(),
+        };
+
+        let Some((minor_before, major_before)) = page_faults() else {
+            return;
+        };
+        for &addr in &addrs {
+            criterion::black_box(symcache.lookup(addr).next());
+        }
+        let (minor_after, major_after) = page_faults().unwrap_or_default();
+
+        eprintln!(
+            "{label}: {} minor and {} major page faults for {FAULT_LOOKUPS} cold lookups",
+            minor_after - minor_before,
+            major_after - major_before,
+        );
+    }
+}
+
+fn bench_index(c: &mut Criterion) {
+    let file = write_symcache();
+    report_page_faults(file.path());
+
+    let buffer = ByteView::open(file.path()).expect("open");
+    let indexed = SymCache::parse(&buffer).expect("parse");
+    let unindexed = indexed.clone().without_range_index();
+    let addrs = random_addrs(1000);
+
+    let mut group = c.benchmark_group("range index");
+    for (label, symcache) in [("index", &indexed), ("binary search", &unindexed)] {
+        group.bench_with_input(BenchmarkId::new("lookup", label), &addrs, |b, addrs| {
+            b.iter(|| {
+                for &addr in addrs {
+                    criterion::black_box(symcache.lookup(addr).next());
+                }
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(bench_indexes, bench_index);
+
+criterion_main!(bench_indexes);
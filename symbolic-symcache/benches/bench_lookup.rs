@@ -0,0 +1,81 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use symbolic_common::ByteView;
+use symbolic_symcache::SymCache;
+use symbolic_testutils::{fixture, Rng};
+
+/// The number of addresses in every batch.
+const BATCH_SIZE: usize = 10_000;
+
+/// Creates batches of addresses within the functions of `symcache`.
+///
+/// - `random`: uniformly distributed, as in profiling samples across the whole image.
+/// - `clustered`: concentrated around a few hot spots, as in stack traces of many threads.
+/// - `sorted`: the random batch in ascending order, which needs no sorting.
+fn batches(symcache: &SymCache<'_>) -> Vec<(&'static str, Vec<u64>)> {
+    let entry_pcs = symcache
+        .functions()
+        .map(|function| function.entry_pc() as u64);
+    let low = entry_pcs.clone().min().unwrap_or_default();
+    let high = entry_pcs.max().unwrap_or_default() + 1;
+    let mut rng = Rng::new();
+
+    let random: Vec<u64> = (0..BATCH_SIZE)
+        .map(|_| low + rng.next_u64() % (high - low))
+        .collect();
+
+    let hot_spots: Vec<u64> = (0..16)
+        .map(|_| low + rng.next_u64() % (high - low))
+        .collect();
+    let clustered = (0..BATCH_SIZE)
+        .map(|_| {
+            let hot_spot = hot_spots[rng.next_u64() as usize % hot_spots.len()];
+            hot_spot + rng.next_u64() % 0x200
+        })
+        .collect();
+
+    let mut sorted = random.clone();
+    sorted.sort_unstable();
+
+    vec![
+        ("random", random),
+        ("clustered", clustered),
+        ("sorted", sorted),
+    ]
+}
+
+fn bench_lookup(c: &mut Criterion) {
+    let buffer = ByteView::open(fixture("symcache/current/linux.symc")).expect("open");
+    let symcache = SymCache::parse(&buffer).expect("parse");
+
+    let mut group = c.benchmark_group("lookup");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+
+    for (label, addrs) in batches(&symcache) {
+        group.bench_with_input(BenchmarkId::new("lookup", label), &addrs, |b, addrs| {
+            b.iter(|| {
+                for &addr in addrs {
+                    criterion::black_box(symcache.lookup(addr).count());
+                }
+            })
+        });
+
+        group.bench_with_input(
+            BenchmarkId::new("lookup_many", label),
+            &addrs,
+            |b, addrs| {
+                b.iter(|| {
+                    for (idx, source_locations) in symcache.lookup_many(addrs) {
+                        criterion::black_box((idx, source_locations.count()));
+                    }
+                })
+            },
+        );
+    }
+
+    group.finish();
+}
+
+criterion_group!(bench_lookups, bench_lookup);
+
+criterion_main!(bench_lookups);
@@ -1,12 +1,94 @@
+use std::borrow::Cow;
+use std::collections::HashMap;
 use std::io::Cursor;
 
-use criterion::{criterion_group, criterion_main, Criterion};
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use gimli::write::{Address, AttributeValue, EndianVec, LineProgram, Sections, Unit};
+use gimli::{constants, Encoding, Format, RunTimeEndian};
 
 use symbolic_common::ByteView;
-use symbolic_debuginfo::Object;
+use symbolic_debuginfo::dwarf::{Dwarf, DwarfDebugSession, DwarfSection, Endian};
+use symbolic_debuginfo::{Object, ObjectKind, SymbolMap};
 use symbolic_symcache::SymCacheConverter;
 use symbolic_testutils::fixture;
 
+/// The number of compilation units in the synthetic DWARF file.
+const UNITS: u64 = 512;
+
+/// DWARF sections generated in memory, keyed by their name without the leading dot.
+struct SyntheticDwarf(HashMap<&'static str, Vec<u8>>);
+
+impl<'d> Dwarf<'d> for &'d SyntheticDwarf {
+    fn endianity(&self) -> Endian {
+        Endian::Little
+    }
+
+    fn raw_section(&self, name: &str) -> Option<DwarfSection<'d>> {
+        Some(DwarfSection {
+            address: 0,
+            offset: 0,
+            align: 1,
+            data: Cow::Borrowed(self.0.get(name)?),
+        })
+    }
+}
+
+/// Generates DWARF with mostly small compilation units and a huge one every 64 units, like a
+/// large C++ binary where a few units instantiate most of the templates.
+fn skewed_dwarf() -> SyntheticDwarf {
+    let encoding = Encoding {
+        format: Format::Dwarf32,
+        version: 4,
+        address_size: 8,
+    };
+
+    let mut dwarf = gimli::write::Dwarf::new();
+    let mut address = 0x1000;
+    for unit_index in 0..UNITS {
+        let functions = if unit_index % 64 == 0 { 20_000 } else { 50 };
+        let unit_id = dwarf.units.add(Unit::new(encoding, LineProgram::none()));
+        let unit = dwarf.units.get_mut(unit_id);
+        let root = unit.root();
+
+        let name = format!("unit{unit_index}.cpp").into_bytes();
+        let entry = unit.get_mut(root);
+        entry.set(constants::DW_AT_name, AttributeValue::String(name));
+        entry.set(
+            constants::DW_AT_low_pc,
+            AttributeValue::Address(Address::Constant(address)),
+        );
+        entry.set(
+            constants::DW_AT_high_pc,
+            AttributeValue::Udata(functions * 0x40),
+        );
+
+        for function in 0..functions {
+            let id = unit.add(root, constants::DW_TAG_subprogram);
+            let name = format!("unit{unit_index}_function{function}").into_bytes();
+            let entry = unit.get_mut(id);
+            entry.set(constants::DW_AT_name, AttributeValue::String(name));
+            entry.set(
+                constants::DW_AT_low_pc,
+                AttributeValue::Address(Address::Constant(address)),
+            );
+            entry.set(constants::DW_AT_high_pc, AttributeValue::Udata(0x40));
+            address += 0x40;
+        }
+    }
+
+    let mut sections = Sections::new(EndianVec::new(RunTimeEndian::Little));
+    dwarf.write(&mut sections).expect("write dwarf");
+
+    let mut map = HashMap::new();
+    sections
+        .for_each(|id, data| {
+            map.insert(&id.name()[1..], data.slice().to_vec());
+            Ok::<_, ()>(())
+        })
+        .unwrap();
+    SyntheticDwarf(map)
+}
+
 fn bench_write_linux(c: &mut Criterion) {
     c.bench_function("write_linux", |b| {
         let buffer = ByteView::open(fixture("linux/crash.debug")).expect("open");
@@ -51,11 +133,72 @@ fn bench_write_breakpad(c: &mut Criterion) {
     });
 }
 
+fn bench_write_threads(c: &mut Criterion) {
+    let mut group = c.benchmark_group("write_threads");
+    let buffer =
+        ByteView::open(fixture("macos/crash.dSYM/Contents/Resources/DWARF/crash")).expect("open");
+
+    for threads in [1, 2, 4, 8] {
+        group.bench_with_input(
+            BenchmarkId::from_parameter(threads),
+            &threads,
+            |b, &threads| {
+                b.iter(|| {
+                    let object = Object::parse(&buffer).expect("parse");
+                    let mut converter = SymCacheConverter::new();
+                    converter.set_threads(threads);
+                    converter.process_object(&object).expect("process_object");
+                    converter
+                        .serialize(&mut Cursor::new(Vec::new()))
+                        .expect("write_object")
+                });
+            },
+        );
+    }
+
+    group.finish();
+}
+
+/// Sweeps the thread count on compilation units of very different sizes, where a worker that
+/// parses a huge unit must not hold up the others.
+fn bench_write_threads_skewed(c: &mut Criterion) {
+    let mut group = c.benchmark_group("write_threads_skewed");
+    group.sample_size(10);
+
+    let dwarf = skewed_dwarf();
+    let session =
+        DwarfDebugSession::parse(&&dwarf, SymbolMap::new(), 0, ObjectKind::Debug).expect("parse");
+
+    for threads in [1, 2, 4, 8, 16, 32] {
+        group.bench_with_input(
+            BenchmarkId::from_parameter(threads),
+            &threads,
+            |b, &threads| {
+                b.iter(|| {
+                    let mut converter = SymCacheConverter::new();
+                    std::thread::scope(|scope| {
+                        for function in session.functions_parallel(scope, threads) {
+                            converter.process_symbolic_function(&function.expect("function"));
+                        }
+                    });
+                    converter
+                        .serialize(&mut Cursor::new(Vec::new()))
+                        .expect("write_object")
+                });
+            },
+        );
+    }
+
+    group.finish();
+}
+
 criterion_group!(
     bench_writer,
     bench_write_linux,
     bench_write_macos,
-    bench_write_breakpad
+    bench_write_breakpad,
+    bench_write_threads,
+    bench_write_threads_skewed
 );
 
 criterion_main!(bench_writer);
@@ -0,0 +1,111 @@
+//! An implicit search index over the address ranges of a SymCache.
+//!
+//! Binary search over the flat `ranges` table touches a new cache line, and for large memory
+//! mapped files often a new page, on almost every probe. Starting with version 9, SymCaches also
+//! contain a small index over every [`BLOCK_SIZE`]th range start, stored in Eytzinger order:
+//! the children of the node at position `k` (counting from one) are stored at `2k` and `2k + 1`.
+//! The top levels of the search tree are thus packed into the first few cache lines of the index,
+//! which stay hot across lookups. A lookup walks the index and then searches a single block of
+//! ranges.
+
+use crate::raw;
+
+/// The number of ranges covered by one node of the index.
+pub(crate) const BLOCK_SIZE: usize = 16;
+
+/// Returns the number of index nodes for the given number of ranges.
+pub(crate) fn index_len(num_ranges: usize) -> usize {
+    num_ranges.div_ceil(BLOCK_SIZE)
+}
+
+/// Builds the range index for the given sorted range starts.
+pub(crate) fn build_index<I>(ranges: I) -> Vec<raw::RangeIndexNode>
+where
+    I: IntoIterator<Item = u32>,
+{
+    let blocks: Vec<_> = ranges
+        .into_iter()
+        .step_by(BLOCK_SIZE)
+        .enumerate()
+        .map(|(block, addr)| raw::RangeIndexNode {
+            addr,
+            range_idx: (block * BLOCK_SIZE) as u32,
+        })
+        .collect();
+
+    // Fill the tree in order, which assigns the sorted nodes to their Eytzinger positions.
+    let mut index = blocks.clone();
+    fill(&mut index, &mut blocks.into_iter(), 1);
+    index
+}
+
+fn fill<I>(index: &mut [raw::RangeIndexNode], nodes: &mut I, k: usize)
+where
+    I: Iterator<Item = raw::RangeIndexNode>,
+{
+    if k <= index.len() {
+        fill(index, nodes, 2 * k);
+        if let Some(node) = nodes.next() {
+            index[k - 1] = node;
+        }
+        fill(index, nodes, 2 * k + 1);
+    }
+}
+
+/// Returns the number of `ranges` that start at or before `addr`.
+///
+/// This is the position at which `addr` would be inserted into `ranges`, equivalent to
+/// `ranges.partition_point(|range| range.0 <= addr)`.
+pub(crate) fn search(index: &[raw::RangeIndexNode], ranges: &[raw::Range], addr: u32) -> usize {
+    if index.is_empty() {
+        return 0;
+    }
+
+    // Descend to a leaf, going right whenever the node starts at or before `addr`.
+    let mut k = 1;
+    while k <= index.len() {
+        k = 2 * k + (index[k - 1].addr <= addr) as usize;
+    }
+
+    // Undo the right turns taken after the last left turn. This leaves the first node that
+    // starts after `addr`, or zero if there is no such node.
+    k >>= k.trailing_ones() + 1;
+
+    let (low, high) = match k {
+        0 => ((index.len() - 1) * BLOCK_SIZE, ranges.len()),
+        k => {
+            let high = index[k - 1].range_idx as usize;
+            (high.saturating_sub(BLOCK_SIZE), high)
+        }
+    };
+
+    // The index is validated against the number of ranges on parse, but guard against corrupted
+    // files that would otherwise panic.
+    match ranges.get(low..high) {
+        Some(block) => low + block.partition_point(|range| range.0 <= addr),
+        None => ranges.partition_point(|range| range.0 <= addr),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_search_matches_binary_search() {
+        for num_ranges in [0, 1, 2, 15, 16, 17, 31, 32, 33, 100, 257, 1000] {
+            let ranges: Vec<_> = (0..num_ranges).map(|i| raw::Range(10 + i * 3)).collect();
+            let index = build_index(ranges.iter().map(|range| range.0));
+            assert_eq!(index.len(), index_len(ranges.len()));
+
+            for addr in 0..(20 + num_ranges * 3) {
+                let expected = ranges.partition_point(|range| range.0 <= addr);
+                assert_eq!(
+                    search(&index, &ranges, addr),
+                    expected,
+                    "{num_ranges} {addr}"
+                );
+            }
+        }
+    }
+}
@@ -12,7 +12,8 @@
 //! 2. Functions
 //! 3. Source Locations
 //! 4. Address Ranges
-//! 5. String Data
+//! 5. Range Index (since version 9)
+//! 6. String Data
 //!
 //! The format uses `u32`s to represent line numbers, addresses, references, and string offsets.
 //! Line numbers use `0` to represent an unknown or invalid value. Addresses, references, and string
@@ -36,6 +37,13 @@
 //!
 //! Ranges are saved as a contiguous list of `u32`s, representing their starting addresses.
 //!
+//! ## Range Index
+//!
+//! Since version 9, the ranges are followed by a search index. Every node of the index covers a
+//! block of 16 consecutive ranges and holds the start address and index of the block's first range.
+//! The nodes are stored in Eytzinger order, i.e. as an implicit binary search tree in which the
+//! children of the node at position `k` (counting from one) are at positions `2k` and `2k + 1`.
+//!
 //! ## Source Locations
 //!
 //! A source location in a symcache represents a possibly-inlined copy of a line in a source file.
@@ -90,7 +98,9 @@
 //!
 //! To look up an address `addr` in a SymCache:
 //!
-//! 1. Find the range covering `addr` via binary search.
+//! 1. Find the range covering `addr`. Since version 9, this walks a search index over blocks of
+//!    ranges in Eytzinger order and then searches a single block. Older versions use binary search
+//!    over all ranges.
 //! 2. Find the source location belonging to this range.
 //! 3. Return an iterator over a series of source locations that starts at the source location found
 //!    in step 2. The iterator climbs up through the inlining hierarchy, ending at the root source
@@ -102,6 +112,7 @@
 #![warn(missing_docs)]
 
 mod error;
+mod index;
 mod lookup;
 mod raw;
 pub mod transform;
@@ -131,7 +142,8 @@ type Result<T, E = Error> = std::result::Result<T, E>;
 /// 6: PR #319: Correct line offsets and spacer line records
 /// 7: PR #459: A new binary format fundamentally based on addr ranges
 /// 8: PR #670: Use LEB128-prefixed string table
-pub const SYMCACHE_VERSION: u32 = 8;
+/// 9: Add an Eytzinger-ordered search index over ranges
+pub const SYMCACHE_VERSION: u32 = 9;
 
 /// The serialized SymCache binary format.
 ///
@@ -144,6 +156,7 @@ pub struct SymCache<'data> {
     functions: &'data [raw::Function],
     source_locations: &'data [raw::SourceLocation],
     ranges: &'data [raw::Range],
+    range_index: &'data [raw::RangeIndexNode],
     string_bytes: &'data [u8],
 }
 
@@ -173,7 +186,7 @@ impl<'data> SymCache<'data> {
         if header.magic != raw::SYMCACHE_MAGIC {
             return Err(ErrorKind::WrongFormat.into());
         }
-        if header.version != SYMCACHE_VERSION && header.version != 7 {
+        if !(7..=SYMCACHE_VERSION).contains(&header.version) {
             return Err(ErrorKind::WrongVersion.into());
         }
 
@@ -195,6 +208,15 @@ impl<'data> SymCache<'data> {
         let (ranges, rest) = raw::Range::slice_from_prefix(rest, header.num_ranges as usize)
             .ok_or(ErrorKind::InvalidRanges)?;
 
+        let (range_index, rest) = if header.version >= 9 {
+            let (_, rest) = align_to(rest, 8).ok_or(ErrorKind::InvalidRanges)?;
+            let index_len = index::index_len(ranges.len());
+            raw::RangeIndexNode::slice_from_prefix(rest, index_len)
+                .ok_or(ErrorKind::InvalidRanges)?
+        } else {
+            (&[][..], rest)
+        };
+
         let (_, rest) = align_to(rest, 8).ok_or(ErrorKind::UnexpectedStringBytes {
             expected: header.string_bytes as usize,
             found: 0,
@@ -213,6 +235,7 @@ impl<'data> SymCache<'data> {
             functions,
             source_locations,
             ranges,
+            range_index,
             string_bytes: rest,
         })
     }
@@ -244,6 +267,16 @@ impl<'data> SymCache<'data> {
         }
     }
 
+    /// Drops the range index, so that lookups use binary search over all ranges.
+    ///
+    /// This is only used to benchmark the index against the lookup of older versions.
+    #[cfg(feature = "bench")]
+    #[doc(hidden)]
+    pub fn without_range_index(mut self) -> Self {
+        self.range_index = &[];
+        self
+    }
+
     /// The version of the SymCache file format.
     pub fn version(&self) -> u32 {
         self.header.version
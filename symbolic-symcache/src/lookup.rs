@@ -1,8 +1,9 @@
+use std::borrow::Cow;
 use std::fmt;
 
-use symbolic_common::{Language, Name, NameMangling};
+use symbolic_common::{gallop, Language, Name, NameMangling};
 
-use super::{raw, SymCache};
+use super::{index, raw, SymCache};
 
 impl<'data> SymCache<'data> {
     /// Looks up an instruction address in the SymCache, yielding an iterator of [`SourceLocation`]s
@@ -18,11 +19,56 @@ impl<'data> SymCache<'data> {
             }
         };
 
+        let range_idx = if self.range_index.is_empty() {
+            match self.ranges.binary_search_by_key(&addr, |r| r.0) {
+                Ok(idx) => Some(idx),
+                Err(0) => None,
+                Err(idx) => Some(idx - 1),
+            }
+        } else {
+            index::search(self.range_index, self.ranges, addr).checked_sub(1)
+        };
+
+        self.source_locations_for_range(range_idx)
+    }
+
+    /// Looks up a batch of instruction addresses in the SymCache.
+    ///
+    /// This is equivalent to calling [`lookup`](Self::lookup) for every address, but the
+    /// addresses are resolved in ascending order with a single forward sweep over the address
+    /// ranges. Each address continues the search from the range of the previous one, which is
+    /// considerably cheaper than a full binary search for large batches and for addresses that
+    /// are close to each other.
+    ///
+    /// Results come in ascending address order, each paired with the index of its address in
+    /// `addrs`. Sorted input is walked as it is, while unsorted input is first sorted into a
+    /// separate list of indexes.
+    pub fn lookup_many<'a>(&'a self, addrs: &'a [u64]) -> LookupMany<'data, 'a> {
+        let order = if addrs.is_sorted() {
+            None
+        } else {
+            let mut order: Vec<usize> = (0..addrs.len()).collect();
+            order.sort_unstable_by_key(|&idx| (addrs[idx], idx));
+            Some(order)
+        };
+
+        LookupMany {
+            cache: self,
+            addrs,
+            order,
+            position: 0,
+            range_cursor: 0,
+        }
+    }
+
+    /// Returns the source locations for the range at `range_idx`, including inlinees.
+    ///
+    /// `range_idx` is the last range starting at or before the looked up address, if any.
+    fn source_locations_for_range(&self, range_idx: Option<usize>) -> SourceLocations<'data, '_> {
         let source_location_start = (self.source_locations.len() - self.ranges.len()) as u32;
-        let mut source_location_idx = match self.ranges.binary_search_by_key(&addr, |r| r.0) {
-            Ok(idx) => source_location_start + idx as u32,
-            Err(0) => u32::MAX,
-            Err(idx) => source_location_start + idx as u32 - 1,
+        let mut source_location_idx = match range_idx {
+            Some(idx) => source_location_start + idx as u32,
+            None => u32::MAX,
         };
 
         if let Some(source_location) = self.source_locations.get(source_location_idx as usize) {
@@ -91,7 +137,7 @@ pub struct File<'data> {
     name: &'data str,
 }
 
-impl File<'_> {
+impl<'data> File<'data> {
     /// Returns this file's full path.
     pub fn full_path(&self) -> String {
         let comp_dir = self.comp_dir.unwrap_or_default();
@@ -103,6 +149,24 @@ impl File<'_> {
 
         full_path
     }
+
+    /// Returns this file's full path, borrowing it from the SymCache where possible.
+    ///
+    /// This is equivalent to [`full_path`](Self::full_path), but does not allocate if the file
+    /// name is already a clean, absolute path or has no directory prefixes.
+    pub fn full_path_cow(&self) -> Cow<'data, str> {
+        let name = self.name;
+        let is_verbatim = name.starts_with('/')
+            || (name.starts_with('<') && name.ends_with('>'))
+            || (self.comp_dir.unwrap_or_default().is_empty()
+                && self.directory.unwrap_or_default().is_empty());
+
+        if is_verbatim {
+            symbolic_common::clean_path(name)
+        } else {
+            Cow::Owned(self.full_path())
+        }
+    }
 }
 
 /// A Function definition as included in the SymCache.
@@ -206,6 +270,53 @@ impl<'data, 'cache> Iterator for SourceLocations<'data, 'cache> {
     }
 }
 
+/// Iterator returned by [`SymCache::lookup_many`]; see documentation there.
+#[derive(Debug, Clone)]
+pub struct LookupMany<'data, 'cache> {
+    cache: &'cache SymCache<'data>,
+    addrs: &'cache [u64],
+    /// Indexes into `addrs` in ascending address order, or `None` if `addrs` is sorted.
+    order: Option<Vec<usize>>,
+    /// The next position in `order`.
+    position: usize,
+    /// The number of ranges that start at or before the previous address.
+    range_cursor: usize,
+}
+
+impl<'data, 'cache> Iterator for LookupMany<'data, 'cache> {
+    type Item = (usize, SourceLocations<'data, 'cache>);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let idx = match self.order {
+            Some(ref order) => *order.get(self.position)?,
+            None if self.position < self.addrs.len() => self.position,
+            None => return None,
+        };
+        self.position += 1;
+
+        let cache = self.cache;
+        let source_locations = match u32::try_from(self.addrs[idx]) {
+            Ok(addr) => {
+                self.range_cursor = gallop(cache.ranges, self.range_cursor, |r| r.0 <= addr);
+                cache.source_locations_for_range(self.range_cursor.checked_sub(1))
+            }
+            Err(_) => SourceLocations {
+                cache,
+                source_location_idx: u32::MAX,
+            },
+        };
+
+        Some((idx, source_locations))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let remaining = self.addrs.len() - self.position;
+        (remaining, Some(remaining))
+    }
+}
+
+impl ExactSizeIterator for LookupMany<'_, '_> {}
+
 /// Iterator returned by [`SymCache::functions`]; see documentation there.
 #[derive(Debug, Clone)]
 pub struct Functions<'data> {
@@ -113,11 +113,24 @@ pub(crate) struct SourceLocation {
 #[repr(C)]
 pub(crate) struct Range(pub(crate) u32);
 
+/// A node of the search index over [`Range`]s, see the `index` module.
+///
+/// The index is stored after the ranges since version 9.
+#[derive(Debug, Clone, Hash, PartialEq, Eq)]
+#[repr(C)]
+pub(crate) struct RangeIndexNode {
+    /// The start address of the first range in the block.
+    pub(crate) addr: u32,
+    /// The index of the first range in the block.
+    pub(crate) range_idx: u32,
+}
+
 unsafe impl Pod for Header {}
 unsafe impl Pod for Function {}
 unsafe impl Pod for File {}
 unsafe impl Pod for SourceLocation {}
 unsafe impl Pod for Range {}
+unsafe impl Pod for RangeIndexNode {}
 
 #[cfg(test)]
 mod tests {
@@ -141,5 +154,8 @@ mod tests {
 
         assert_eq!(mem::size_of::<Range>(), 4);
         assert_eq!(mem::align_of::<Range>(), 4);
+
+        assert_eq!(mem::size_of::<RangeIndexNode>(), 8);
+        assert_eq!(mem::align_of::<RangeIndexNode>(), 4);
     }
 }
@@ -1,7 +1,7 @@
 //! Resolves IL2CPP-compiled native symbols into their managed equivalents using a mapping file
 //! before writing them to a SymCache.
 
-use symbolic_il2cpp::LineMapping;
+use symbolic_il2cpp::{LineMapping, LineMappingCache};
 
 use super::{File, Function, SourceLocation, Transformer};
 
@@ -37,3 +37,24 @@ impl Transformer for LineMapping {
         sl
     }
 }
+
+impl Transformer for LineMappingCache<'_> {
+    fn transform_function<'f>(&'f mut self, f: Function<'f>) -> Function<'f> {
+        f
+    }
+
+    fn transform_source_location<'f>(
+        &'f mut self,
+        mut sl: SourceLocation<'f>,
+    ) -> SourceLocation<'f> {
+        let full_path = full_path(&sl.file);
+        if let Some((mapped_file, mapped_line)) = self.lookup(&full_path, sl.line) {
+            sl.file.name = mapped_file.into();
+            sl.file.comp_dir = None;
+            sl.file.directory = None;
+            sl.line = mapped_line;
+        }
+
+        sl
+    }
+}
@@ -9,7 +9,7 @@ use symbolic_common::{Arch, DebugId};
 use symbolic_debuginfo::{DebugSession, FileFormat, Function, ObjectLike, Symbol};
 use watto::{Pod, StringTable, Writer};
 
-use super::{raw, transform};
+use super::{index, raw, transform};
 use crate::raw::NO_SOURCE_LOCATION;
 use crate::{Error, ErrorKind};
 
@@ -31,6 +31,11 @@ pub struct SymCacheConverter<'a> {
     /// A list of transformers that are used to transform each function / source location.
     transformers: transform::Transformers<'a>,
 
+    /// The number of threads used to parse debug information in [`process_object`].
+    ///
+    /// [`process_object`]: SymCacheConverter::process_object
+    threads: usize,
+
     string_table: StringTable,
     /// The set of all [`raw::File`]s that have been added to this `Converter`.
     files: IndexSet<raw::File>,
@@ -79,6 +84,16 @@ impl<'a> SymCacheConverter<'a> {
         self.debug_id = debug_id;
     }
 
+    /// Sets the number of threads used to parse debug information.
+    ///
+    /// With more than one thread, [`process_object`](Self::process_object) parses the
+    /// compilation units of DWARF files concurrently. Functions are still added in their original
+    /// order, so the resulting SymCache is identical to the one written with a single thread.
+    /// Defaults to a single thread.
+    pub fn set_threads(&mut self, threads: usize) {
+        self.threads = threads;
+    }
+
     // Methods processing symbolic-debuginfo [`ObjectLike`] below:
     // Feel free to move these to a separate file.
 
@@ -99,11 +114,15 @@ impl<'a> SymCacheConverter<'a> {
 
         self.is_windows_object = matches!(object.file_format(), FileFormat::Pe | FileFormat::Pdb);
 
-        for function in session.functions() {
-            let function = function.map_err(|e| Error::new(ErrorKind::BadDebugFile, e))?;
+        std::thread::scope(|scope| {
+            for function in session.functions_parallel(scope, self.threads) {
+                let function = function.map_err(|e| Error::new(ErrorKind::BadDebugFile, e))?;
 
-            self.process_symbolic_function(&function);
-        }
+                self.process_symbolic_function(&function);
+            }
+
+            Ok::<_, Error>(())
+        })?;
 
         for symbol in object.symbols() {
             self.process_symbolic_symbol(&symbol);
@@ -525,6 +544,11 @@ impl<'a> SymCacheConverter<'a> {
         }
         writer.align_to(8)?;
 
+        for node in index::build_index(self.ranges.keys().copied()) {
+            writer.write_all(node.as_bytes())?;
+        }
+        writer.align_to(8)?;
+
         writer.write_all(&string_bytes)?;
 
         Ok(())
@@ -82,3 +82,31 @@ fn test_lookup() -> Result<(), Error> {
 
     Ok(())
 }
+
+#[test]
+fn test_lookup_many() -> Result<(), Error> {
+    let buffer = ByteView::open(fixture("symcache/current/linux.symc"))?;
+    let symcache = SymCache::parse(&buffer)?;
+
+    let mut addrs: Vec<u64> = (0..0x16000).step_by(0x35).collect();
+    addrs.reverse();
+    addrs.extend([0x1558, u64::MAX, 0x1558, 0]);
+
+    let mut seen = vec![false; addrs.len()];
+    let mut previous = 0;
+    for (idx, source_locations) in symcache.lookup_many(&addrs) {
+        assert!(addrs[idx] >= previous);
+        previous = addrs[idx];
+        seen[idx] = true;
+
+        let expected: Vec<_> = symcache.lookup(addrs[idx]).collect();
+        assert_eq!(source_locations.collect::<Vec<_>>(), expected);
+    }
+    assert!(seen.iter().all(|&seen| seen));
+
+    addrs.sort_unstable();
+    let indexes: Vec<_> = symcache.lookup_many(&addrs).map(|(idx, _)| idx).collect();
+    assert_eq!(indexes, (0..addrs.len()).collect::<Vec<_>>());
+
+    Ok(())
+}
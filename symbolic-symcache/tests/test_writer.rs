@@ -25,7 +25,7 @@ fn test_write_header_linux() -> Result<(), Error> {
     let symcache = SymCache::parse(&buffer)?;
     insta::assert_debug_snapshot!(symcache, @r#"
     SymCache {
-        version: 8,
+        version: 9,
         debug_id: DebugId {
             uuid: "c0bcc3f1-9827-fe65-3058-404b2831d9e6",
             appendix: 0,
@@ -42,6 +42,33 @@ fn test_write_header_linux() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn test_write_parallel() -> Result<(), Error> {
+    for path in [
+        "linux/crash.debug",
+        "macos/crash.dSYM/Contents/Resources/DWARF/crash",
+    ] {
+        let buffer = ByteView::open(fixture(path))?;
+        let object = Object::parse(&buffer)?;
+
+        let mut expected = Vec::new();
+        let mut converter = SymCacheConverter::new();
+        converter.process_object(&object)?;
+        converter.serialize(&mut Cursor::new(&mut expected))?;
+
+        for threads in [2, 4] {
+            let mut buffer = Vec::new();
+            let mut converter = SymCacheConverter::new();
+            converter.set_threads(threads);
+            converter.process_object(&object)?;
+            converter.serialize(&mut Cursor::new(&mut buffer))?;
+            assert!(buffer == expected, "{path} with {threads} threads");
+        }
+    }
+
+    Ok(())
+}
+
 #[test]
 fn test_write_functions_linux() -> Result<(), Error> {
     let buffer = ByteView::open(fixture("linux/crash.debug"))?;
@@ -69,7 +96,7 @@ fn test_write_header_macos() -> Result<(), Error> {
     let symcache = SymCache::parse(&buffer)?;
     insta::assert_debug_snapshot!(symcache, @r#"
     SymCache {
-        version: 8,
+        version: 9,
         debug_id: DebugId {
             uuid: "67e9247c-814e-392b-a027-dbde6748fcbf",
             appendix: 0,
@@ -207,6 +234,26 @@ fn test_lookup_modulo_u16() -> Result<(), Error> {
     Ok(())
 }
 
+#[test]
+fn test_full_path_cow() -> Result<(), Error> {
+    for path in ["linux/crash.debug", "windows/crash.pdb", "xul.sym"] {
+        let buffer = ByteView::open(fixture(path))?;
+        let object = Object::parse(&buffer)?;
+
+        let mut buffer = Vec::new();
+        let mut converter = SymCacheConverter::new();
+        converter.process_object(&object)?;
+        converter.serialize(&mut Cursor::new(&mut buffer))?;
+        let symcache = SymCache::parse(&buffer)?;
+
+        for file in symcache.files() {
+            assert_eq!(file.full_path_cow(), file.full_path());
+        }
+    }
+
+    Ok(())
+}
+
 /// This tests the fix for the bug described in
 /// https://github.com/getsentry/symbolic/issues/646.
 #[test]
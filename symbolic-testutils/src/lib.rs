@@ -31,3 +31,65 @@ pub fn fixture<P: AsRef<Path>>(path: P) -> PathBuf {
 
     full_path
 }
+
+/// Reads a Breakpad fixture and repeats its function and stack records `repeat` times.
+///
+/// Tests and benchmarks use this to get files that span many chunks when parsed in parallel. The
+/// file must contain `FUNC` records, and the `STACK` records must come last.
+///
+/// # Example
+///
+/// ```
+/// use symbolic_testutils::large_breakpad_file;
+///
+/// let data = large_breakpad_file("windows/crash.sym", 2);
+/// assert!(data.starts_with(b"MODULE "));
+/// ```
+pub fn large_breakpad_file<P: AsRef<Path>>(path: P, repeat: usize) -> Vec<u8> {
+    let path = fixture(path);
+    let text = std::fs::read_to_string(&path)
+        .unwrap_or_else(|e| panic!("Failed to read {}: {e}", path.display()));
+    let func = text.find("\nFUNC ").expect("no FUNC records") + 1;
+    let stack = text.find("\nSTACK ").map_or(text.len(), |index| index + 1);
+
+    let mut data = text[..func].to_owned();
+    data.push_str(&text[func..stack].repeat(repeat));
+    data.push_str(&text[stack..].repeat(repeat));
+    data.into_bytes()
+}
+
+/// A xorshift pseudo-random number generator with a fixed seed.
+///
+/// Benchmarks use it to generate inputs that are identical across runs.
+///
+/// # Example
+///
+/// ```
+/// use symbolic_testutils::Rng;
+///
+/// let mut rng = Rng::new();
+/// assert_eq!(rng.next_u64(), Rng::new().next_u64());
+/// ```
+#[derive(Clone, Debug)]
+pub struct Rng(u64);
+
+impl Rng {
+    /// Creates a generator with the default seed.
+    pub fn new() -> Self {
+        Self(0x2545_f491_4f6c_dd1d)
+    }
+
+    /// Returns the next pseudo-random number.
+    pub fn next_u64(&mut self) -> u64 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        self.0
+    }
+}
+
+impl Default for Rng {
+    fn default() -> Self {
+        Self::new()
+    }
+}